@@ -1,18 +1,62 @@
 import ast
+import os
 import struct
+import pickle
+import re
+import hashlib
 from sys import argv
 from os import path
-from pprint import pprint
+from multiprocessing import Pool
 
 from typing import Union, Callable
 
-global_vars = set([
-    
-])
+builtin_vars = [
+    'print',
+    'input',
+    'join',
+    'flush',
+    'readline',
+    'lines',
+    'open',
+    'read',
+    'mmap_file',
+    'split',
+    'find',
+    'len',
+    'array',
+    'sum',
+    'min',
+    'max',
+    'compare',
+    'filter',
+    'map',
+    'reduce',
+    'sort',
+]
+
+global_vars = set(builtin_vars)
+# Every global declared by the program, in order (see `generate_bytecode`)
+declared_globals: list[str] = []
+
+def declare_global(name:str):
+    global_vars.add(name)
+    declared_globals.append(name)
+
+# Element types of `array`, as their DataType value in the VM and their struct format
+array_types = {
+    'i16': (2,'<h'),
+    'i32': (3,'<i'),
+    'i64': (4,'<q'),
+}
+
+# Directory of the compilation cache (see `generate_bytecode`), None when it is disabled
+cache_dir: Union[str,None] = None
+# Lines of the file being compiled
+source_lines: list[str] = []
 
-if len(argv) <= 2:
-    print('Usage: \x1b[35m%s\x1b[39m %s \x1b[36m<output.bsk>\x1b[39m' % (argv[0],'\x1b[32m'+argv[1]+'\x1b[39m' if len(argv)==2 else '\x1b[36m<input.py>\x1b[39m'))
-    exit(1)
+# Objects are only reused by the exact same compiler
+with open(__file__,'rb') as f:
+    compiler_version = hashlib.sha256(f.read()).hexdigest()
 
 auto_idx = {}
 auto_key = '<auto>'
@@ -75,8 +119,9 @@ class Label:
         
 def Enum(name:str, parents: tuple, attributes:dict):
     t = type(name,parents,attributes)
+    values = set(attributes.values())
     def has(val:int) -> bool:
-        return val in attributes.values()
+        return val in values
     t.has = has
     return t
 
@@ -111,10 +156,61 @@ class OpCodes(metaclass=Enum):
     PushNull       = auto()
     Equals         = auto()
     LoadFunction   = auto()
+    DictBegin      = auto()
+    DictEnd        = auto()
+    Subscript      = auto()
+    StoreSubscript = auto()
+    PushArray      = auto()
+    Slice          = auto()
+    PushBool       = auto()
+    NotEquals      = auto()
+    Less           = auto()
+    LessEquals     = auto()
+    Greater        = auto()
+    GreaterEquals  = auto()
+    JumpIfNotCmp   = auto()
+    ForRangeI64    = auto()
+    Import         = auto()
     
+# The comparison operators, with their instruction and the comparison byte of `JumpIfNotCmp`
+compare_ops: dict[type,tuple[int,int]] = {
+    ast.Eq:    (OpCodes.Equals,        0),
+    ast.NotEq: (OpCodes.NotEquals,     1),
+    ast.Lt:    (OpCodes.Less,          2),
+    ast.LtE:   (OpCodes.LessEquals,    3),
+    ast.Gt:    (OpCodes.Greater,       4),
+    ast.GtE:   (OpCodes.GreaterEquals, 5),
+}
+    
+# The amount of values each instruction pops and then pushes,
+# ListBegin/ListEnd, DictBegin/DictEnd and ListExpand are handled by `stack_depth`
+stack_effects: dict[int,tuple[int,int]] = {
+    OpCodes.StoreSimple:    (1,0), OpCodes.LoadSimple:     (0,1),
+    OpCodes.StoreDynamic:   (1,0), OpCodes.LoadDynamic:    (0,1),
+    OpCodes.StoreGlobal:    (1,0), OpCodes.LoadGlobal:     (0,1),
+    OpCodes.PushString:     (0,1), OpCodes.PushChar:       (0,1),
+    OpCodes.PushI16:        (0,1), OpCodes.PushI32:        (0,1),
+    OpCodes.PushI64:        (0,1), OpCodes.PushBool:       (0,1),
+    OpCodes.PushNull:       (0,1), OpCodes.PushArray:      (0,1),
+    OpCodes.LoadFunction:   (0,1), OpCodes.RemoveDynamic:  (0,0),
+    OpCodes.Add:            (2,1), OpCodes.Sub:            (2,1),
+    OpCodes.Div:            (2,1), OpCodes.Mul:            (2,1),
+    OpCodes.Equals:         (2,1), OpCodes.NotEquals:      (2,1),
+    OpCodes.Less:           (2,1), OpCodes.LessEquals:     (2,1),
+    OpCodes.Greater:        (2,1), OpCodes.GreaterEquals:  (2,1),
+    OpCodes.Subscript:      (2,1), OpCodes.StoreSubscript: (3,0),
+    OpCodes.Slice:          (3,1), OpCodes.Pop:            (1,0),
+    OpCodes.Dup:            (1,2), OpCodes.Call:           (2,1),
+    OpCodes.Return:         (1,0), OpCodes.Jump:           (0,0),
+    OpCodes.JumpIf:         (1,0), OpCodes.JumpIfNot:      (1,0),
+    OpCodes.JumpIfNotCmp:   (2,0), OpCodes.ForRangeI64:    (0,0),
+    OpCodes.Import:         (0,0),
+}
+
 class SpecialOp(metaclass=Enum):
     Label       = auto('SpecialOp','OpCode')
     AddCompiled = auto()
+    Line        = auto()
 
 Instruction = tuple[int,...]
     
@@ -124,6 +220,7 @@ class Program:
     vars:         list[str]
     globals:      set[str]
     instructions: list[Instruction]
+    loops:        list[tuple[Label,Label]]
     file:         str
     name:         str
     
@@ -132,6 +229,7 @@ class Program:
         self.vars = []
         self.globals = set([])
         self.instructions = []
+        self.loops = []
         self.file = file
         self.name = name
         
@@ -149,14 +247,84 @@ class Program:
             return [(OpCodes.LoadGlobal,v)]
         else:
             return [(OpCodes.LoadDynamic,v)]
+        
+    def store_var(self, v:str) -> list[Instruction]:
+        """
+        Stores the value on top of the stack in a variable
+        """
+        if v in self.globals:
+            return [(OpCodes.StoreGlobal,v)]
+        elif v in self.vars:
+            return [(OpCodes.StoreSimple,self.vars.index(v))]
+        else:
+            return [(OpCodes.StoreDynamic,v)]
+    
+    def jump_if_not(self, test:ast.expr, l:Label) -> list[Instruction]:
+        """
+        Jumps to `l` if `test` is false, a single comparison is fused with the jump
+        """
+        if isinstance(test,ast.Compare) and len(test.ops) == 1 and type(test.ops[0]) in compare_ops:
+            return [*self.explore(test.left),*self.explore(test.comparators[0]),(OpCodes.JumpIfNotCmp,compare_ops[type(test.ops[0])][1],l)]
+        return [*self.explore(test),(OpCodes.JumpIfNot,l)]
+    
+    def range_args(self, node:ast.For) -> Union[tuple[ast.expr,ast.expr,int],None]:
+        """
+        Returns the start, stop and step of `for _ in range(...)` when the step is a constant, so that it can be lowered to a counted loop
+        """
+        it = node.iter
+        if not isinstance(it,ast.Call) or not isinstance(it.func,ast.Name) or it.func.id != 'range' or it.func.id in self.vars or it.keywords:
+            return None
+        if len(it.args) == 1:
+            return (ast.Constant(0,lineno=it.lineno,col_offset=it.col_offset),it.args[0],1)
+        if len(it.args) not in (2,3):
+            return None
+        step = it.args[2] if len(it.args) == 3 else ast.Constant(1)
+        neg = isinstance(step,ast.UnaryOp) and isinstance(step.op,ast.USub)
+        if neg: step = step.operand
+        if not isinstance(step,ast.Constant) or type(step.value) != int or step.value == 0:
+            return None
+        return (it.args[0],it.args[1],-step.value if neg else step.value)
+    
+    def array_literal(self, node:ast.Call) -> Union[tuple[str,list[int]],None]:
+        """
+        Returns the element type and values of `array([...])` when they are all constants, so that it can be built in a single instruction
+        """
+        if not isinstance(node.func,ast.Name) or node.func.id != 'array' or node.func.id in self.vars or node.keywords:
+            return None
+        if len(node.args) not in (1,2) or not isinstance(node.args[0],ast.List):
+            return None
+        t = 'i64'
+        if len(node.args) == 2:
+            if not isinstance(node.args[1],ast.Constant) or node.args[1].value not in array_types:
+                return None
+            t = node.args[1].value
+        values = []
+        for e in node.args[0].elts:
+            if isinstance(e,ast.UnaryOp) and isinstance(e.op,ast.USub) and isinstance(e.operand,ast.Constant) and type(e.operand.value) == int:
+                values.append(-e.operand.value)
+            elif isinstance(e,ast.Constant) and type(e.value) == int:
+                values.append(e.value)
+            else:
+                return None
+        bits = int(t[1:])
+        for e, v in zip(node.args[0].elts,values):
+            assert -(1 << (bits-1)) <= v < (1 << (bits-1)), '%s:%d:%d: %d does not fit in an array of %s' % (self.file,e.lineno,e.col_offset,v,t)
+        return (t,values)
     
     def explore(self, node:ast.expr, flags:list[str]=[]) -> list[Instruction]:
         i = []
         
         loc = (self.file,node.lineno,node.col_offset)
         
+        if isinstance(node,ast.stmt):
+            i.append((SpecialOp.Line,node.lineno))
+        
         if isinstance(node,ast.Expr):
             i.extend(self.explore(node.value))
+            i.append((OpCodes.Pop,))
+            
+        elif isinstance(node,ast.Call) and self.array_literal(node) is not None:
+            i.append((OpCodes.PushArray,*self.array_literal(node)))
             
         elif isinstance(node,ast.Call):
             i.extend(self.explore(node.func))
@@ -173,6 +341,8 @@ class Program:
         elif isinstance(node,ast.Constant):
             if type(node.value) == str:
                 i.append((OpCodes.PushString,self.add_constant(node.value)))
+            elif type(node.value) == bool:
+                i.append((OpCodes.PushBool,node.value))
             elif type(node.value) == int:
                 i.append((OpCodes.PushI64,node.value*(-1 if 'neg' in flags else 1)))
             elif node.value == None:
@@ -186,11 +356,33 @@ class Program:
                 i.extend(self.explore(sub_node))
             i.append((OpCodes.ListEnd,))
             
+        elif isinstance(node,ast.Dict):
+            i.append((OpCodes.DictBegin,))
+            for k, v in zip(node.keys,node.values):
+                assert k is not None, '%s:%d:%d: Dict unpacking is not supported' % loc
+                i.extend(self.explore(k))
+                i.extend(self.explore(v))
+            i.append((OpCodes.DictEnd,))
+            
+        elif isinstance(node,ast.Subscript) and isinstance(node.slice,ast.Slice):
+            assert node.slice.step is None, '%s:%d:%d: Slice steps are not supported' % loc
+            i.extend(self.explore(node.value))
+            for bound in (node.slice.lower,node.slice.upper):
+                if bound is None:
+                    i.append((OpCodes.PushNull,))
+                else:
+                    i.extend(self.explore(bound))
+            i.append((OpCodes.Slice,))
+            
+        elif isinstance(node,ast.Subscript):
+            i.extend(self.explore(node.value))
+            i.extend(self.explore(node.slice))
+            i.append((OpCodes.Subscript,))
+            
         elif isinstance(node,ast.If):
             l_if = Label()
             l_not = Label()
-            i.extend(self.explore(node.test))
-            i.append((OpCodes.JumpIfNot,l_not))
+            i.extend(self.jump_if_not(node.test,l_not))
             for sub_node in node.body:
                 i.extend(self.explore(sub_node))
             i.append((OpCodes.Jump,l_if))
@@ -199,6 +391,66 @@ class Program:
                 i.extend(self.explore(sub_node))
             i.append((SpecialOp.Label,l_if))
             
+        elif isinstance(node,ast.While):
+            l_loop = Label()
+            l_else = Label()
+            l_end = Label()
+            i.append((SpecialOp.Label,l_loop))
+            i.extend(self.jump_if_not(node.test,l_else))
+            self.loops.append((l_loop,l_end))
+            for sub_node in node.body:
+                i.extend(self.explore(sub_node))
+            self.loops.pop()
+            i.append((OpCodes.Jump,l_loop))
+            i.append((SpecialOp.Label,l_else))
+            for sub_node in node.orelse:
+                i.extend(self.explore(sub_node))
+            i.append((SpecialOp.Label,l_end))
+            
+        elif isinstance(node,ast.For):
+            # Only `for _ in range(...)` is supported, the counter and the end of the range live in hidden slots,
+            # and `ForRangeI64` steps the counter and jumps back to the body in a single instruction
+            r = self.range_args(node)
+            assert r is not None, '%s:%d:%d: Only `for _ in range(...)` loops with a constant step are supported' % loc
+            assert isinstance(node.target,ast.Name), '%s:%d:%d: Expected Name as a loop target, got %s' % (*loc,str(type(node.target)))
+            start, stop, step = r
+            counter = len(self.vars)
+            self.vars.append('<range %d>' % counter)
+            end = len(self.vars)
+            self.vars.append('<range %d end>' % counter)
+            l_body = Label()
+            l_next = Label()
+            l_else = Label()
+            l_end = Label()
+            i.extend(self.explore(start))
+            i.append((OpCodes.StoreSimple,counter))
+            i.extend(self.explore(stop))
+            i.append((OpCodes.StoreSimple,end))
+            i.append((OpCodes.LoadSimple,counter))
+            i.append((OpCodes.LoadSimple,end))
+            i.append((OpCodes.JumpIfNotCmp,compare_ops[ast.Lt if step > 0 else ast.Gt][1],l_else))
+            i.append((SpecialOp.Label,l_body))
+            i.append((OpCodes.LoadSimple,counter))
+            i.extend(self.store_var(node.target.id))
+            self.loops.append((l_next,l_end))
+            for sub_node in node.body:
+                i.extend(self.explore(sub_node))
+            self.loops.pop()
+            i.append((SpecialOp.Label,l_next))
+            i.append((OpCodes.ForRangeI64,counter,end,step,l_body))
+            i.append((SpecialOp.Label,l_else))
+            for sub_node in node.orelse:
+                i.extend(self.explore(sub_node))
+            i.append((SpecialOp.Label,l_end))
+            
+        elif isinstance(node,ast.Break):
+            assert self.loops, '%s:%d:%d: `break` outside of a loop' % loc
+            i.append((OpCodes.Jump,self.loops[-1][1]))
+            
+        elif isinstance(node,ast.Continue):
+            assert self.loops, '%s:%d:%d: `continue` outside of a loop' % loc
+            i.append((OpCodes.Jump,self.loops[-1][0]))
+            
         elif isinstance(node,ast.BinOp):
             
             if isinstance(node.op,ast.Add):
@@ -236,10 +488,10 @@ class Program:
             
             assert len(node.ops) == 1, '%s:%d:%d: Only one comparison at a time is supported, got %s' % (*loc,repr(list(map(lambda v: type(v).__name__,node.ops))),)
             
-            if isinstance(node.ops[0],ast.Eq):
+            if type(node.ops[0]) in compare_ops:
                 i.extend(self.explore(node.left))
                 i.extend(self.explore(node.comparators[0]))
-                i.append((OpCodes.Equals,))
+                i.append((compare_ops[type(node.ops[0])][0],))
                 
             else:
                 assert False, '%s:%d:%d: Got unknown comparison : %s' % (*loc,repr(type(node.ops[0]).__name__),)
@@ -247,31 +499,53 @@ class Program:
         elif isinstance(node,ast.Assign):
             
             assert len(node.targets) == 1, '%s:%d:%d Expected 1 assignation target, got %s' % (*loc,repr([n for n in node.targets]))
-            assert isinstance(node.targets[0],ast.Name), '%s:%d:%d Expected Name as an assignation target, got %s' % (*loc,str(type(node.targets[0])))
+            assert isinstance(node.targets[0],(ast.Name,ast.Subscript)), '%s:%d:%d Expected Name or Subscript as an assignation target, got %s' % (*loc,str(type(node.targets[0])))
             
             i.extend(self.explore(node.value))
             
-            tgt:str = node.targets[0].id
+            if isinstance(node.targets[0],ast.Subscript):
+                t = node.targets[0]
+                assert not isinstance(t.slice,ast.Slice), '%s:%d:%d: Slices are not supported' % loc
+                i.extend(self.explore(t.value))
+                i.extend(self.explore(t.slice))
+                i.append((OpCodes.StoreSubscript,))
+                return i
             
-            if tgt in self.globals:
-                i.append((OpCodes.StoreGlobal,tgt))
-            elif tgt in self.vars:
-                i.append((OpCodes.StoreSimple,tgt))
-            else:
-                i.append((OpCodes.StoreDynamic,tgt))
+            i.extend(self.store_var(node.targets[0].id))
                 
         elif isinstance(node,ast.FunctionDef):
             
-            self.globals.add(node.name)
+            declare_global(node.name)
             
             n = remove_tag(add_name(self.name,node.name),'main')
-            b = generate_bytecode(n,self.name,node.body,init_instructions=[(OpCodes.LoadDynamic,'...'),(OpCodes.ListExpand,),*((OpCodes.StoreSimple,i) for i,a in reversed(list(enumerate(node.args.args))))],init_vars=[a.arg for a in node.args.args])
+            b = generate_bytecode(n,self.file,node.body,first_line=node.lineno,init_instructions=[(OpCodes.LoadDynamic,'...'),(OpCodes.ListExpand,len(node.args.args)),*((OpCodes.StoreSimple,i) for i,a in reversed(list(enumerate(node.args.args))))],init_vars=[a.arg for a in node.args.args])
             for c in b: i.append((SpecialOp.AddCompiled,c))
             i.append((OpCodes.LoadFunction,n))
             i.append((OpCodes.StoreGlobal,node.name))
             
+        elif isinstance(node,ast.Return):
+            if node.value is None:
+                i.append((OpCodes.PushNull,))
+            else:
+                i.extend(self.explore(node.value))
+            i.append((OpCodes.Return,))
+            
         elif isinstance(node,ast.Global):
-            for n in node.names: self.globals.add(n)
+            for n in node.names: declare_global(n)
+            
+        elif isinstance(node,ast.Import):
+            # The module is the top-level object of the file it was compiled from, which the VM runs the first time it is imported
+            for a in node.names:
+                assert a.asname is None and '.' not in a.name, '%s:%d:%d: Only `import module` is supported' % loc
+                i.append((OpCodes.Import,'file;'+a.name+'.py'))
+            
+        elif isinstance(node,ast.ImportFrom):
+            # Every module shares the same globals, so the names it defines only have to be known as globals
+            assert node.level == 0 and '.' not in node.module, '%s:%d:%d: Only `from module import name` is supported' % loc
+            i.append((OpCodes.Import,'file;'+node.module+'.py'))
+            for a in node.names:
+                assert a.asname is None and a.name != '*', '%s:%d:%d: Only `from module import name` is supported' % loc
+                declare_global(a.name)
             
         else:
             assert False, '%s:%d:%d: Got unknown node type: %s' % (*loc,repr(type(node)))
@@ -292,7 +566,120 @@ def repass_u64(l:Label,addr:int) -> Callable[[bytearray],None]:
         b[addr:addr+8] = struct.pack('<Q',l.addr)
     return r
 
-def generate_bytecode( name:str, path:str, body:list[ast.expr], init_instructions:list[Instruction]=[], init_vars:list[str]=[] ) -> list[CompiledCode]:
+def line_table(path:str, first_line:int, lines:list[tuple[int,int]]) -> bytearray:
+    """
+    Encodes the line table of an object
+    The table is a list of (address increment, line increment) byte pairs starting at address 0 and `first_line`
+    Increments that do not fit in a byte are split over several pairs
+    """
+    t = bytearray()
+    t += bytes(path,'utf-8') + b'\0'
+    t += struct.pack('<I',first_line)
+    addr, line = 0, first_line
+    for a, l in lines:
+        da, dl = a-addr, l-line
+        while da > 255:
+            t += struct.pack('<Bb',255,0)
+            da -= 255
+        while dl > 127 or dl < -128:
+            s = 127 if dl > 0 else -128
+            t += struct.pack('<Bb',da,s)
+            da = 0
+            dl -= s
+        t += struct.pack('<Bb',da,dl)
+        addr, line = a, l
+    return t
+
+def stack_depth(instructions:list[Instruction]) -> int:
+    """
+    Computes the maximum depth the operand stack of an object can reach, by following every path through its instructions
+    The VM sizes the stack of the object with it, and does not check its pushes
+    """
+    labels = { i[1]: n for n, i in enumerate(instructions) if i[0] == SpecialOp.Label }
+    seen: dict[int,tuple[int,tuple[int,...]]] = {}
+    # (instruction, depth, depths at which the open lists begin)
+    todo: list[tuple[int,int,tuple[int,...]]] = [(0,0,())]
+    top = 0
+    while todo:
+        n, d, bases = todo.pop()
+        while n < len(instructions):
+            if n in seen:
+                assert seen[n] == (d,bases), 'Inconsistent stack depth at instruction %d: %s' % (n,repr(instructions[n]))
+                break
+            seen[n] = (d,bases)
+            i = instructions[n]
+            n += 1
+            if SpecialOp.has(i[0]):
+                continue
+            if i[0] in (OpCodes.ListBegin,OpCodes.DictBegin):
+                bases += (d,)
+            elif i[0] in (OpCodes.ListEnd,OpCodes.DictEnd):
+                d = bases[-1]+1
+                bases = bases[:-1]
+            elif i[0] == OpCodes.ListExpand:
+                d += i[1]-1
+            else:
+                pop, push = stack_effects[i[0]]
+                assert d >= pop, 'Stack underflow at instruction %d: %s' % (n-1,repr(i))
+                d += push-pop
+            top = max(top,d)
+            if i[0] in (OpCodes.Jump,OpCodes.JumpIf,OpCodes.JumpIfNot,OpCodes.JumpIfNotCmp,OpCodes.ForRangeI64):
+                todo.append((labels[i[-1]],d,bases))
+            if i[0] in (OpCodes.Jump,OpCodes.Return):
+                break
+    return top
+
+def rebase_lines(b:bytes, delta:int) -> bytes:
+    """
+    Moves the line table of an object by `delta` lines, only its first line is absolute
+    """
+    o = 4
+    for _ in range(struct.unpack_from('<I',b,0)[0]):
+        o += 4+struct.unpack_from('<I',b,o)[0]
+    n = struct.unpack_from('<I',b,o)[0]
+    o += 4
+    for _ in range(n):
+        o = b.index(b'\0',o)+1
+    # The stack depth, the size of the line table and the path of the file come before the first line
+    o = b.index(b'\0',o+8)+1
+    b = bytearray(b)
+    struct.pack_into('<I',b,o,struct.unpack_from('<I',b,o)[0]+delta)
+    return bytes(b)
+
+def generate_bytecode( name:str, path:str, body:list[ast.expr], first_line:int=1, init_instructions:list[Instruction]=[], init_vars:list[str]=[] ) -> list[CompiledCode]:
+    """
+    Compiles a body into its object, preceded by the objects of the functions it defines
+    When the cache is enabled, the objects are reused if the compiler, the name, the source of the body and the globals it
+    names did not change, the source determines the AST without having to walk it, and does not depend on where the body is in
+    the file, so that editing a function does not invalidate the ones after it
+    The globals that compiling the body declared are declared again when it is reused
+    """
+    if cache_dir is None or not body:
+        return compile_body(name,path,body,first_line,init_instructions,init_vars)
+    
+    text = ''.join(source_lines[first_line-1:body[-1].end_lineno])
+    h = hashlib.sha256()
+    for part in (compiler_version,name,path,repr(init_instructions),repr(init_vars),text,*sorted(global_vars.intersection(re.findall(r'[A-Za-z_]\w*',text)))):
+        h.update(bytes(part,'utf-8')+b'\0')
+    file = os.path.join(cache_dir,h.hexdigest())
+    
+    if os.path.exists(file):
+        with open(file,'rb') as f:
+            objects, declared, line = pickle.load(f)
+        for n in declared: declare_global(n)
+        return [ CompiledCode(n,rebase_lines(b,first_line-line) if first_line != line else b) for n, b in objects ]
+    
+    start = len(declared_globals)
+    compiled = compile_body(name,path,body,first_line,init_instructions,init_vars)
+    
+    # Written under another name first, so that other compilations never read it partially
+    tmp = '%s.%d' % (file,os.getpid())
+    with open(tmp,'wb') as f:
+        pickle.dump(([ (o.name,bytes(o.bytes)) for o in compiled ],declared_globals[start:],first_line),f)
+    os.replace(tmp,file)
+    return compiled
+
+def compile_body( name:str, path:str, body:list[ast.expr], first_line:int, init_instructions:list[Instruction], init_vars:list[str] ) -> list[CompiledCode]:
     
     compiled:list[CompiledCode] = []
 
@@ -308,8 +695,6 @@ def generate_bytecode( name:str, path:str, body:list[ast.expr], init_instruction
     p.instructions.append((OpCodes.PushNull,))
     p.instructions.append((OpCodes.Return,))
     
-    pprint(p.instructions)
-    
     header = bytearray()
     
     header += struct.pack('<I',len(p.constants))
@@ -324,9 +709,15 @@ def generate_bytecode( name:str, path:str, body:list[ast.expr], init_instruction
     for v in p.vars:
         header += bytes(v,'utf-8') + b'\0'
         
+    header += struct.pack('<I',stack_depth(p.instructions))
+        
     repass: list[tuple[Callable[[bytearray],None]]] = []
     
+    lines: list[tuple[int,int]] = []
+    
     bytecode = bytearray()
+    
+    caches = 0
         
     for i in p.instructions:
         
@@ -337,15 +728,26 @@ def generate_bytecode( name:str, path:str, body:list[ast.expr], init_instruction
                 
             elif i[0] == SpecialOp.AddCompiled:
                 compiled.append(i[1])
+                
+            elif i[0] == SpecialOp.Line:
+                if lines and lines[-1][0] == len(bytecode):
+                    lines.pop()
+                if (lines[-1][1] if lines else first_line) != i[1]:
+                    lines.append((len(bytecode),i[1]))
             
         else:
         
             bytecode += struct.pack('<B',i[0])
             
-            if i[0] in (OpCodes.LoadDynamic,OpCodes.LoadGlobal,OpCodes.LoadFunction,OpCodes.StoreDynamic,OpCodes.StoreGlobal):
+            if i[0] in (OpCodes.LoadGlobal,OpCodes.Call):
+                # Every one of them gets its own inline cache in the VM
+                bytecode += struct.pack('<I',caches)
+                caches += 1
+                
+            if i[0] in (OpCodes.LoadDynamic,OpCodes.LoadGlobal,OpCodes.LoadFunction,OpCodes.StoreDynamic,OpCodes.StoreGlobal,OpCodes.Import):
                 bytecode += bytes(i[1],'utf-8') + b'\0'
                 
-            elif i[0] in (OpCodes.LoadSimple,OpCodes.StoreSimple):
+            elif i[0] in (OpCodes.LoadSimple,OpCodes.StoreSimple,OpCodes.ListExpand):
                 bytecode += struct.pack('<I',i[1])
             
             elif i[0] == OpCodes.PushString:
@@ -359,6 +761,23 @@ def generate_bytecode( name:str, path:str, body:list[ast.expr], init_instruction
                 bytecode += struct.pack('<i',i[1])
             elif i[0] == OpCodes.PushI64:
                 bytecode += struct.pack('<q',i[1])
+            elif i[0] == OpCodes.PushBool:
+                bytecode += struct.pack('<B',i[1])
+            elif i[0] == OpCodes.PushArray:
+                t, fmt = array_types[i[1]]
+                bytecode += struct.pack('<BI',t,len(i[2]))
+                for v in i[2]:
+                    bytecode += struct.pack(fmt,v)
+                
+            elif i[0] == OpCodes.JumpIfNotCmp:
+                bytecode += struct.pack('<B',i[1])
+                repass.append((repass_u64(i[2],len(bytecode)),))
+                bytecode += struct.pack('<Q',0)
+                
+            elif i[0] == OpCodes.ForRangeI64:
+                bytecode += struct.pack('<IIq',i[1],i[2],i[3])
+                repass.append((repass_u64(i[4],len(bytecode)),))
+                bytecode += struct.pack('<Q',0)
                 
             elif i[0] in (OpCodes.JumpIfNot,OpCodes.JumpIf,OpCodes.Jump):
                 a = i[1]
@@ -371,19 +790,123 @@ def generate_bytecode( name:str, path:str, body:list[ast.expr], init_instruction
     for i in repass:
         i[0](bytecode)
         
+    lnotab = line_table(path,first_line,lines)
+    header += struct.pack('<I',len(lnotab))
+    header += lnotab
+        
     compiled.append( CompiledCode(name, header+bytecode) )
         
     return compiled
 
-with open(argv[1],'r') as f:
-    m = ast.parse(f.read(),argv[1],'exec',type_comments=True)
+def compile_module(args:tuple[str,str]) -> list[tuple[str,bytes]]:
+    """
+    Compiles a file into its objects, ran in its own process when there are several of them
+    """
+    file, name = args
+    # A process can compile several modules, they do not see each other's globals
+    global source_lines
+    global_vars.clear()
+    global_vars.update(builtin_vars)
+    declared_globals.clear()
+    with open(file,'r') as f:
+        src = f.read()
+    source_lines = src.splitlines(True)
+    m = ast.parse(src,file,'exec',type_comments=True)
+    return [ (o.name,o.bytes) for o in generate_bytecode(name,file,m.body) ]
+
+def read_image(file:str) -> list[tuple[str,bytes]]:
+    """
+    Reads the objects of a program that was already compiled
+    """
+    with open(file,'rb') as f:
+        b = f.read()
+    if struct.unpack_from('<I',b,0)[0] == 0xffffffff:
+        _, count, cap, _ = struct.unpack_from('<IIQQ',b,0)
+        o = 24+cap*16
+    else:
+        count = struct.unpack_from('<I',b,0)[0]
+        o = 4
+    objects = []
+    for _ in range(count):
+        sz = struct.unpack_from('<Q',b,o)[0]
+        e = b.index(b'\0',o+8)
+        objects.append((str(b[o+8:e],'utf-8'),b[e+1:o+8+sz]))
+        o += 8+sz
+    return objects
+
+def name_hash(name:bytes) -> int:
+    """
+    FNV-1a, like the VM
+    """
+    h = 14695981039346656037
+    for c in name:
+        h = ((h^c)*1099511628211) & 0xffffffffffffffff
+    return h
+
+def link(objects:list[tuple[str,bytes]]) -> bytearray:
+    """
+    Links objects into an image with a hash table of their names, so that the VM only decodes the ones that are used
+    The image starts with a marker (plain images start with their amount of objects), the amount of objects,
+    the capacity of the table and the slot of the object tagged `main`, followed by the table, an open-addressed one
+    with linear probing whose slots are the hash of a name and the offset of its object (0 when empty), and then the objects
+    """
+    names = [ bytes(n,'utf-8','ignore') for n, _ in objects ]
+    assert len(set(names)) == len(names), 'Two objects have the same name'
+    cap = 8
+    while cap < len(objects)*2: cap *= 2
+    slots = [(0,0)]*cap
+    entry = None
+    o = 24+cap*16
+    for n, (name, b) in zip(names,objects):
+        h = name_hash(n)
+        s = h & (cap-1)
+        while slots[s][1] != 0: s = (s+1) & (cap-1)
+        slots[s] = (h,o)
+        if 'main' in parts_name(name)[2]:
+            assert entry is None, 'Two objects are tagged `main`'
+            entry = s
+        o += 8+len(n)+1+len(b)
+    assert entry is not None, 'No object is tagged `main`'
+    image = bytearray(struct.pack('<IIQQ',0xffffffff,len(objects),cap,entry))
+    for h, o in slots:
+        image += struct.pack('<QQ',h,o)
+    for n, (_, b) in zip(names,objects):
+        image += struct.pack('<Q',len(n)+1+len(b)) + n + b'\0' + b
+    return image
+
+if __name__ == '__main__':
+    
+    inputs: list[str] = []
+    jobs: Union[int,None] = None
+    
+    args = iter(argv[1:])
+    for arg in args:
+        if arg == '--cache': cache_dir = next(args,None)
+        elif arg == '--jobs': jobs = int(next(args,'0')) or None
+        else: inputs.append(arg)
     
-    b = generate_bytecode('file;'+path.basename(argv[1])+'/main',argv[1],m.body)
+    if len(inputs) < 2:
+        print('Usage: \x1b[35m%s\x1b[39m [--cache \x1b[36m<dir>\x1b[39m] [--jobs \x1b[36m<n>\x1b[39m] \x1b[36m<input.py|input.bsk>\x1b[39m... \x1b[36m<output.bsk>\x1b[39m' % (argv[0],))
+        exit(1)
     
-    objects = [ bytes(o.name,'utf-8','ignore')+b'\0'+o.bytes for o in b ]
+    output = inputs.pop()
+    if cache_dir is not None: os.makedirs(cache_dir,exist_ok=True)
+    
+    # The first module is the program, the others are only ran when they are imported,
+    # modules that were already compiled are linked as they are, without their `main` tag
+    sources = [ (f,'file;'+path.basename(f)+('/main' if n == 0 else '')) for n, f in enumerate(inputs) if not f.endswith('.bsk') ]
+    if len(sources) > 1:
+        with Pool(jobs) as pool:
+            compiled = dict(zip((f for f, _ in sources),pool.map(compile_module,sources)))
+    else:
+        compiled = { f: compile_module((f,n)) for f, n in sources }
+    
+    objects: list[tuple[str,bytes]] = []
+    for n, f in enumerate(inputs):
+        if f.endswith('.bsk'):
+            objects += [ (o if n == 0 else remove_tag(o,'main'),b) for o, b in read_image(f) ]
+        else:
+            objects += compiled[f]
     
-    with open(argv[2],'wb') as out:
-        out.write(struct.pack('<I',len(objects)))
-        for obj in objects:
-            out.write(struct.pack('<Q',len(obj)))
-            out.write(obj)
\ No newline at end of file
+    with open(output,'wb') as out:
+        out.write(link(objects))
@@ -0,0 +1,229 @@
+#include "basik.h"
+
+#include <ctype.h>
+
+/********************************\
+*          Translation           *
+\********************************/
+
+static const char* cmp_names[] = { "CmpEq", "CmpNe", "CmpLt", "CmpLe", "CmpGt", "CmpGe" };
+
+/**
+ * Writes a name of the bytecode in a comment, without anything that could end the comment early
+ */
+static void comment_name(FILE* out, const char* name) {
+    for (const char* c = name; *c; c++)
+        fputc((isalnum((uint8_t)*c) || strchr("_;:/. <>",*c)) ? *c : '?',out);
+}
+
+/**
+ * Translates one object into `static Result aot_<index>(Code* code)`, every instruction becomes the call to its
+ * implementation in `ops.h` with its operands as constants, and every jump a `goto`
+ * Like `run`, the GC collects after each instruction and strings are read from the bytecode itself
+ */
+static void translate(FILE* out, Code* code, size_t index) {
+    const uint8_t* orig = code->orig;
+    const uint8_t* end = (const uint8_t*)code->bytecode+code->bytecode_sz;
+
+    // The addresses that are jumped to need a label
+    size_t sz = end-orig;
+    bool* target = new bool[sz+1]();
+    for (const uint8_t* p = orig; p < end; p += instr_size(p,end)) {
+        if (*p == OpCodes::Jump || *p == OpCodes::JumpIf || *p == OpCodes::JumpIfNot) target[*(uint64_t*)(p+1)] = true;
+        else if (*p == OpCodes::JumpIfNotCmp) target[*(uint64_t*)(p+2)] = true;
+        else if (*p == OpCodes::ForRangeI64) target[*(uint64_t*)(p+17)] = true;
+    }
+
+    fprintf(out,"// ");
+    comment_name(out,code->obj->full_name);
+    fprintf(out,"\nstatic Result aot_%zu(Code* code) {\n",index);
+    fprintf(out,"    basik_val* ret = nullptr;\n");
+    fprintf(out,"    bool t = false;\n");
+    fprintf(out,"    (void)t;\n");
+
+    for (const uint8_t* p = orig; p < end; p += instr_size(p,end)) {
+        size_t addr = p-orig;
+        // The address errors point to, like in `run`
+        size_t instr = addr+1;
+        const uint8_t* o = p+1;
+        if (target[addr]) fprintf(out,"L%zu:\n",addr);
+        switch (*p) {
+            case OpCodes::End:
+                fprintf(out,"    goto leave;\n");
+                continue;
+            case OpCodes::StoreSimple:
+                fprintf(out,"    OP_CHECK(op_store_simple(code,%zu,%u));\n",instr,*(uint32_t*)o); break;
+            case OpCodes::StoreDynamic:
+                fprintf(out,"    OP_CHECK(op_store_dynamic(code,%zu,(const char*)code->orig+%zu));\n",instr,addr+1); break;
+            case OpCodes::StoreGlobal:
+                fprintf(out,"    OP_CHECK(op_store_global(code,%zu,(const char*)code->orig+%zu));\n",instr,addr+1); break;
+            case OpCodes::LoadSimple:
+                fprintf(out,"    OP_CHECK(op_load_simple(code,%zu,%u));\n",instr,*(uint32_t*)o); break;
+            case OpCodes::LoadDynamic:
+                fprintf(out,"    OP_CHECK(op_load_dynamic(code,%zu,(const char*)code->orig+%zu));\n",instr,addr+1); break;
+            case OpCodes::LoadGlobal:
+                fprintf(out,"    OP_CHECK(op_load_global(code,%zu,%u,(const char*)code->orig+%zu)); // ",instr,*(uint32_t*)o,addr+5);
+                comment_name(out,(const char*)o+4);
+                fprintf(out,"\n");
+                break;
+            case OpCodes::RemoveDynamic:
+                fprintf(out,"    code->dynvar_rem((const char*)code->orig+%zu);\n",addr+1); break;
+            case OpCodes::PushChar:
+                fprintf(out,"    code->stack_push(val_char(%u));\n",*o); break;
+            case OpCodes::PushI16:
+                fprintf(out,"    code->stack_push(val_i16(%d));\n",*(int16_t*)o); break;
+            case OpCodes::PushI32:
+                fprintf(out,"    code->stack_push(val_i32((int32_t)%" PRId32 "ll));\n",*(int32_t*)o); break;
+            case OpCodes::PushI64:
+                fprintf(out,"    code->stack_push(val_i64((int64_t)0x%" PRIx64 "ull));\n",*(uint64_t*)o); break;
+            case OpCodes::PushBool:
+                fprintf(out,"    code->stack_push(val_bool(%s));\n",*o ? "true" : "false"); break;
+            case OpCodes::PushString:
+                fprintf(out,"    code->stack_push(code->const_data[%d]->val);\n",*(int32_t*)o); break;
+            case OpCodes::PushNull:
+                fprintf(out,"    code->stack_push(nullptr);\n"); break;
+            case OpCodes::PushArray:
+                fprintf(out,"    OP_CHECK(op_push_array(code,%zu,(DataType)%u,%u,code->orig+%zu));\n",instr,*o,*(uint32_t*)(o+1),addr+6); break;
+            case OpCodes::ListBegin: case OpCodes::DictBegin:
+                fprintf(out,"    code->list_stack.push(code->stacki);\n"); break;
+            case OpCodes::ListEnd:
+                fprintf(out,"    op_list_end(code);\n"); break;
+            case OpCodes::DictEnd:
+                fprintf(out,"    OP_CHECK(op_dict_end(code,%zu));\n",instr); break;
+            case OpCodes::Subscript:
+                fprintf(out,"    OP_CHECK(op_subscript(code,%zu));\n",instr); break;
+            case OpCodes::StoreSubscript:
+                fprintf(out,"    OP_CHECK(op_store_subscript(code,%zu));\n",instr); break;
+            case OpCodes::Slice:
+                fprintf(out,"    OP_CHECK(op_slice(code,%zu));\n",instr); break;
+            case OpCodes::ListExpand:
+                fprintf(out,"    OP_CHECK(op_list_expand(code,%zu,%u));\n",instr,*(uint32_t*)o); break;
+            case OpCodes::Add:
+                fprintf(out,"    OP_CHECK(op_arith<'+'>(code,%zu));\n",instr); break;
+            case OpCodes::Sub:
+                fprintf(out,"    OP_CHECK(op_arith<'-'>(code,%zu));\n",instr); break;
+            case OpCodes::Mul:
+                fprintf(out,"    OP_CHECK(op_arith<'*'>(code,%zu));\n",instr); break;
+            case OpCodes::Div:
+                fprintf(out,"    OP_CHECK(op_arith<'/'>(code,%zu));\n",instr); break;
+            case OpCodes::Equals: case OpCodes::NotEquals: case OpCodes::Less: case OpCodes::LessEquals: case OpCodes::Greater: case OpCodes::GreaterEquals: {
+                ArrayCmp cmp = *p == OpCodes::Equals ? CmpEq : (ArrayCmp)(CmpNe+(*p-OpCodes::NotEquals));
+                fprintf(out,"    OP_CHECK(op_compare_push(code,%zu,%s));\n",instr,cmp_names[cmp]);
+                break;
+            }
+            case OpCodes::Pop:
+                fprintf(out,"    code->stack_pop();\n"); break;
+            case OpCodes::Dup:
+                fprintf(out,"    { basik_val* v = code->stack_pop(); code->stack_push(v); code->stack_push(v); }\n"); break;
+            // The GC collects before the jump, like it does after any other instruction
+            case OpCodes::Jump:
+                fprintf(out,"    code->gc->collect();\n");
+                fprintf(out,"    goto L%" PRIu64 ";\n",*(uint64_t*)o);
+                continue;
+            case OpCodes::JumpIf: case OpCodes::JumpIfNot:
+                fprintf(out,"    t = %scode->is_val_true(code->stack_pop());\n",*p == OpCodes::JumpIfNot ? "!" : "");
+                fprintf(out,"    code->gc->collect();\n");
+                fprintf(out,"    if (t) goto L%" PRIu64 ";\n",*(uint64_t*)o);
+                continue;
+            case OpCodes::JumpIfNotCmp:
+                fprintf(out,"    OP_CHECK(op_compare(code,%zu,%s,&t));\n",instr,cmp_names[*o]);
+                fprintf(out,"    code->gc->collect();\n");
+                fprintf(out,"    if (!t) goto L%" PRIu64 ";\n",*(uint64_t*)(o+1));
+                continue;
+            case OpCodes::ForRangeI64:
+                fprintf(out,"    OP_CHECK(op_for_range(code,%zu,%u,%u,%" PRId64 "ll,&t));\n",instr,*(uint32_t*)o,*(uint32_t*)(o+4),*(int64_t*)(o+8));
+                fprintf(out,"    code->gc->collect();\n");
+                fprintf(out,"    if (t) goto L%" PRIu64 ";\n",*(uint64_t*)(o+16));
+                continue;
+            case OpCodes::Return:
+                fprintf(out,"    ret = op_return(code);\n");
+                fprintf(out,"    goto leave;\n");
+                continue;
+            case OpCodes::Call:
+                // Builtins point their errors to `prog`
+                fprintf(out,"    code->prog = code->orig+%zu;\n",addr+5);
+                fprintf(out,"    OP_CHECK(op_call(code,%zu,%u));\n",instr,*(uint32_t*)o);
+                break;
+            case OpCodes::LoadFunction:
+                fprintf(out,"    op_load_function(code,(const char*)code->orig+%zu); // ",addr+1);
+                comment_name(out,(const char*)o);
+                fprintf(out,"\n");
+                break;
+            case OpCodes::Import:
+                fprintf(out,"    OP_CHECK(op_import(code,%zu,(const char*)code->orig+%zu)); // ",instr,addr+1);
+                comment_name(out,(const char*)o);
+                fprintf(out,"\n");
+                break;
+        }
+        fprintf(out,"    code->gc->collect();\n");
+    }
+    if (target[sz]) fprintf(out,"L%zu:\n",sz);
+    fprintf(out,"    goto leave;\n");
+    fprintf(out,"leave:\n");
+    fprintf(out,"    return op_leave(code,ret);\n");
+    fprintf(out,"}\n\n");
+
+    delete[] target;
+}
+
+bool aot_translate(VM* vm, const uint8_t* image, size_t sz, const char* source, FILE* out) {
+    // Objects are listed in the order they were decoded, which `aot_main` does the same way
+    if (!vm->objects->load_all()) {
+        fprintf(stderr,"Malformed program, exitting.\n");
+        return false;
+    }
+    for (size_t i = 0; i < vm->objects->size; i++) {
+        Result r = pre_run(vm->objects->data[i]->code);
+        if (r.except != nullptr) {
+            print_exception(stderr,r.except);
+            return false;
+        }
+    }
+
+    fprintf(out,"// Compiled ahead of time from `");
+    comment_name(out,source);
+    fprintf(out,"` by `basik --aot`, build it with `./tasks/build.bash -aot <this file>`\n\n");
+    fprintf(out,"#include \"basik.h\"\n#include \"ops.h\"\n\n");
+    fprintf(out,"#define OP_CHECK(e) if (BasikException* except = (e)) return Result{except,nullptr}\n\n");
+
+    // The program itself is still needed for the names, constants and line tables of the objects
+    fprintf(out,"alignas(8) static uint8_t image[] = {");
+    for (size_t i = 0; i < sz; i++) fprintf(out,"%s0x%02x,",i%16 ? "" : "\n    ",image[i]);
+    fprintf(out,"\n};\n\n");
+
+    for (size_t i = 0; i < vm->objects->size; i++) translate(out,vm->objects->data[i]->code,i);
+
+    fprintf(out,"static const aot_object objects[] = {\n");
+    for (size_t i = 0; i < vm->objects->size; i++) fprintf(out,"    { aot_%zu },\n",i);
+    fprintf(out,"};\n\n");
+
+    fprintf(out,"int main(int argc, const char** argv) {\n");
+    fprintf(out,"    return aot_main(argc,argv,image,sizeof(image),objects,%zu);\n",vm->objects->size);
+    fprintf(out,"}\n");
+    return true;
+}
+
+/********************************\
+*            Running             *
+\********************************/
+
+int aot_main(int argc, const char** argv, uint8_t* image, size_t sz, const aot_object* objects, size_t count) {
+    VM* vm = new VM();
+    for (int i = 1; i < argc; i++)
+        if (!strcmp(argv[i],"--line-buffered")) vm->glob->output->line_buffered = true;
+    if (!vm->load(image,sz) || !vm->objects->load_all() || vm->objects->size != count) {
+        fprintf(stderr,"Malformed program, exitting.\n");
+        return 1;
+    }
+    for (size_t i = 0; i < count; i++) vm->objects->data[i]->code->native = objects[i].native;
+
+    Result res = vm->run();
+
+    vm->glob->output->flush();
+
+    if (res.except != nullptr) {
+        print_exception(stderr,res.except);
+        return 1;
+    }
+    return 0;
+}
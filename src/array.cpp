@@ -0,0 +1,391 @@
+#include "basik.h"
+
+/********************************\
+*          Typed arrays          *
+\********************************/
+
+/**
+ * The kernels are plain loops that the compiler vectorizes, on x86-64 Linux they are compiled for
+ * both AVX2 and the baseline (SSE2), and the dynamic loader picks the best one for the CPU once at startup
+ * They are always optimized, even in unoptimized builds, since vectorization is the whole point of them
+ */
+#if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__) && !defined(__clang__)
+    #define BASIK_KERNEL __attribute__((target_clones("avx2","default"),optimize("O3"))) static
+#elif defined(__GNUC__) && !defined(__clang__)
+    #define BASIK_KERNEL __attribute__((optimize("O3"))) static
+#else
+    #define BASIK_KERNEL static
+#endif
+
+// Arithmetic is done on the unsigned type so that overflows wrap around instead of being undefined
+#define BASIK_ARRAY_KERNELS(T,U,S) \
+    BASIK_KERNEL void add_vv_##S(T* o, const T* a, const T* b, size_t n) { for (size_t i = 0; i < n; i++) o[i] = (T)((U)a[i] + (U)b[i]); } \
+    BASIK_KERNEL void sub_vv_##S(T* o, const T* a, const T* b, size_t n) { for (size_t i = 0; i < n; i++) o[i] = (T)((U)a[i] - (U)b[i]); } \
+    BASIK_KERNEL void mul_vv_##S(T* o, const T* a, const T* b, size_t n) { for (size_t i = 0; i < n; i++) o[i] = (T)((U)a[i] * (U)b[i]); } \
+    BASIK_KERNEL void add_vs_##S(T* o, const T* a, T s, size_t n) { for (size_t i = 0; i < n; i++) o[i] = (T)((U)a[i] + (U)s); } \
+    BASIK_KERNEL void sub_vs_##S(T* o, const T* a, T s, size_t n) { for (size_t i = 0; i < n; i++) o[i] = (T)((U)a[i] - (U)s); } \
+    BASIK_KERNEL void rsub_vs_##S(T* o, const T* a, T s, size_t n) { for (size_t i = 0; i < n; i++) o[i] = (T)((U)s - (U)a[i]); } \
+    BASIK_KERNEL void mul_vs_##S(T* o, const T* a, T s, size_t n) { for (size_t i = 0; i < n; i++) o[i] = (T)((U)a[i] * (U)s); } \
+    BASIK_KERNEL int64_t sum_##S(const T* a, size_t n) { uint64_t r = 0; for (size_t i = 0; i < n; i++) r += (uint64_t)(int64_t)a[i]; return (int64_t)r; } \
+    BASIK_KERNEL T min_##S(const T* a, size_t n) { T r = a[0]; for (size_t i = 1; i < n; i++) r = a[i] < r ? a[i] : r; return r; } \
+    BASIK_KERNEL T max_##S(const T* a, size_t n) { T r = a[0]; for (size_t i = 1; i < n; i++) r = a[i] > r ? a[i] : r; return r; } \
+    BASIK_KERNEL void eq_##S(T* o, const T* a, T s, size_t n) { for (size_t i = 0; i < n; i++) o[i] = a[i] == s; } \
+    BASIK_KERNEL void ne_##S(T* o, const T* a, T s, size_t n) { for (size_t i = 0; i < n; i++) o[i] = a[i] != s; } \
+    BASIK_KERNEL void lt_##S(T* o, const T* a, T s, size_t n) { for (size_t i = 0; i < n; i++) o[i] = a[i] <  s; } \
+    BASIK_KERNEL void le_##S(T* o, const T* a, T s, size_t n) { for (size_t i = 0; i < n; i++) o[i] = a[i] <= s; } \
+    BASIK_KERNEL void gt_##S(T* o, const T* a, T s, size_t n) { for (size_t i = 0; i < n; i++) o[i] = a[i] >  s; } \
+    BASIK_KERNEL void ge_##S(T* o, const T* a, T s, size_t n) { for (size_t i = 0; i < n; i++) o[i] = a[i] >= s; }
+
+BASIK_ARRAY_KERNELS(int16_t,uint16_t,i16)
+BASIK_ARRAY_KERNELS(int32_t,uint32_t,i32)
+BASIK_ARRAY_KERNELS(int64_t,uint64_t,i64)
+
+/**
+ * Filtering does not vectorize well, it is written without branches instead so that
+ * it does not depend on how predictable the data is
+ */
+template<typename T>
+static size_t filter(T* o, const T* a, ArrayCmp cmp, T s, size_t n) {
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        bool keep;
+             if (cmp == CmpEq) keep = a[i] == s;
+        else if (cmp == CmpNe) keep = a[i] != s;
+        else if (cmp == CmpLt) keep = a[i] <  s;
+        else if (cmp == CmpLe) keep = a[i] <= s;
+        else if (cmp == CmpGt) keep = a[i] >  s;
+        else                   keep = a[i] >= s;
+        o[k] = a[i];
+        k += keep;
+    }
+    return k;
+}
+
+// Array
+
+BasikArray::BasikArray(DataType type, size_t size) {
+    this->type = type;
+    this->size = size;
+    this->data = nullptr;
+    if (size > (SIZE_MAX-63)/BasikArray::elem_size(type)) return;
+    // Aligned for the vector loads, and never empty so that `data` is always valid
+    size_t sz = (size*BasikArray::elem_size(type)+63) & ~(size_t)63;
+#if defined(_WIN32)
+    this->data = _aligned_malloc(sz ? sz : 64,64);
+#else
+    this->data = aligned_alloc(64,sz ? sz : 64);
+#endif
+    if (this->data != nullptr) memset(this->data,0,sz);
+}
+
+BasikArray* BasikArray::create(DataType type, size_t size) {
+    BasikArray* a = new BasikArray(type,size);
+    if (a->data != nullptr) return a;
+    delete a;
+    return nullptr;
+}
+
+BasikArray::~BasikArray() {
+#if defined(_WIN32)
+    _aligned_free(this->data);
+#else
+    free(this->data);
+#endif
+}
+
+size_t BasikArray::elem_size(DataType type) {
+    if (type == DataType::I16) return 2;
+    if (type == DataType::I32) return 4;
+    return 8;
+}
+
+bool BasikArray::fits(DataType type, int64_t v) {
+    if (type == DataType::I16) return v >= INT16_MIN && v <= INT16_MAX;
+    if (type == DataType::I32) return v >= INT32_MIN && v <= INT32_MAX;
+    return true;
+}
+
+int64_t BasikArray::get(size_t i) {
+    if (this->type == DataType::I16) return ((int16_t*)this->data)[i];
+    if (this->type == DataType::I32) return ((int32_t*)this->data)[i];
+    return ((int64_t*)this->data)[i];
+}
+
+void BasikArray::set(size_t i, int64_t v) {
+         if (this->type == DataType::I16) ((int16_t*)this->data)[i] = (int16_t)v;
+    else if (this->type == DataType::I32) ((int32_t*)this->data)[i] = (int32_t)v;
+    else                                  ((int64_t*)this->data)[i] = v;
+}
+
+basik_val* BasikArray::box(size_t i) {
+    if (this->type == DataType::I16) return val_i16(((int16_t*)this->data)[i]);
+    if (this->type == DataType::I32) return val_i32(((int32_t*)this->data)[i]);
+    return val_i64(((int64_t*)this->data)[i]);
+}
+
+// Operations
+
+BasikArray* array_binop(char op, BasikArray* a, BasikArray* b) {
+    BasikArray* r = new BasikArray(a->type,a->size);
+    if (a->type == DataType::I16) {
+             if (op == '+') add_vv_i16((int16_t*)r->data,(int16_t*)a->data,(int16_t*)b->data,a->size);
+        else if (op == '-') sub_vv_i16((int16_t*)r->data,(int16_t*)a->data,(int16_t*)b->data,a->size);
+        else                mul_vv_i16((int16_t*)r->data,(int16_t*)a->data,(int16_t*)b->data,a->size);
+    } else if (a->type == DataType::I32) {
+             if (op == '+') add_vv_i32((int32_t*)r->data,(int32_t*)a->data,(int32_t*)b->data,a->size);
+        else if (op == '-') sub_vv_i32((int32_t*)r->data,(int32_t*)a->data,(int32_t*)b->data,a->size);
+        else                mul_vv_i32((int32_t*)r->data,(int32_t*)a->data,(int32_t*)b->data,a->size);
+    } else {
+             if (op == '+') add_vv_i64((int64_t*)r->data,(int64_t*)a->data,(int64_t*)b->data,a->size);
+        else if (op == '-') sub_vv_i64((int64_t*)r->data,(int64_t*)a->data,(int64_t*)b->data,a->size);
+        else                mul_vv_i64((int64_t*)r->data,(int64_t*)a->data,(int64_t*)b->data,a->size);
+    }
+    return r;
+}
+
+BasikArray* array_binop_scalar(char op, BasikArray* a, int64_t s, bool reversed) {
+    BasikArray* r = new BasikArray(a->type,a->size);
+    if (a->type == DataType::I16) {
+             if (op == '+')              add_vs_i16((int16_t*)r->data,(int16_t*)a->data,(int16_t)s,a->size);
+        else if (op == '-' && reversed) rsub_vs_i16((int16_t*)r->data,(int16_t*)a->data,(int16_t)s,a->size);
+        else if (op == '-')              sub_vs_i16((int16_t*)r->data,(int16_t*)a->data,(int16_t)s,a->size);
+        else                             mul_vs_i16((int16_t*)r->data,(int16_t*)a->data,(int16_t)s,a->size);
+    } else if (a->type == DataType::I32) {
+             if (op == '+')              add_vs_i32((int32_t*)r->data,(int32_t*)a->data,(int32_t)s,a->size);
+        else if (op == '-' && reversed) rsub_vs_i32((int32_t*)r->data,(int32_t*)a->data,(int32_t)s,a->size);
+        else if (op == '-')              sub_vs_i32((int32_t*)r->data,(int32_t*)a->data,(int32_t)s,a->size);
+        else                             mul_vs_i32((int32_t*)r->data,(int32_t*)a->data,(int32_t)s,a->size);
+    } else {
+             if (op == '+')              add_vs_i64((int64_t*)r->data,(int64_t*)a->data,s,a->size);
+        else if (op == '-' && reversed) rsub_vs_i64((int64_t*)r->data,(int64_t*)a->data,s,a->size);
+        else if (op == '-')              sub_vs_i64((int64_t*)r->data,(int64_t*)a->data,s,a->size);
+        else                             mul_vs_i64((int64_t*)r->data,(int64_t*)a->data,s,a->size);
+    }
+    return r;
+}
+
+Result array_arith(Code* code, size_t instr, char op, basik_val* a, basik_val* b) {
+    int64_t s;
+    if (a->type == DataType::Array && b->type == DataType::Array) {
+        BasikArray* aa = (BasikArray*)a->data;
+        BasikArray* ab = (BasikArray*)b->data;
+        if (aa->type != ab->type) return Result{new BasikException(instr,code,"Unsupported '%c' betwen Array of %s and Array of %s",op,get_data_type_str(aa->type),get_data_type_str(ab->type)),nullptr};
+        if (aa->size != ab->size) return Result{new BasikException(instr,code,"Unsupported '%c' betwen Arrays of different sizes (%zu and %zu)",op,aa->size,ab->size),nullptr};
+        return Result{nullptr,new basik_val{DataType::Array,array_binop(op,aa,ab)}};
+    }
+    if (a->type == DataType::Array && int_value(b,&s))
+        return Result{nullptr,new basik_val{DataType::Array,array_binop_scalar(op,(BasikArray*)a->data,s,false)}};
+    if (b->type == DataType::Array && int_value(a,&s))
+        return Result{nullptr,new basik_val{DataType::Array,array_binop_scalar(op,(BasikArray*)b->data,s,true)}};
+    return Result{new BasikException(instr,code,"Unsupported '%c' betwen %s and %s",op,get_data_type_str(a->type),get_data_type_str(b->type)),nullptr};
+}
+
+int64_t array_sum(BasikArray* a) {
+    if (a->type == DataType::I16) return sum_i16((int16_t*)a->data,a->size);
+    if (a->type == DataType::I32) return sum_i32((int32_t*)a->data,a->size);
+    return sum_i64((int64_t*)a->data,a->size);
+}
+
+int64_t array_min(BasikArray* a) {
+    if (a->type == DataType::I16) return min_i16((int16_t*)a->data,a->size);
+    if (a->type == DataType::I32) return min_i32((int32_t*)a->data,a->size);
+    return min_i64((int64_t*)a->data,a->size);
+}
+
+int64_t array_max(BasikArray* a) {
+    if (a->type == DataType::I16) return max_i16((int16_t*)a->data,a->size);
+    if (a->type == DataType::I32) return max_i32((int32_t*)a->data,a->size);
+    return max_i64((int64_t*)a->data,a->size);
+}
+
+#define BASIK_ARRAY_COMPARE(T,S) \
+         if (cmp == CmpEq) eq_##S((T*)r->data,(T*)a->data,(T)s,a->size); \
+    else if (cmp == CmpNe) ne_##S((T*)r->data,(T*)a->data,(T)s,a->size); \
+    else if (cmp == CmpLt) lt_##S((T*)r->data,(T*)a->data,(T)s,a->size); \
+    else if (cmp == CmpLe) le_##S((T*)r->data,(T*)a->data,(T)s,a->size); \
+    else if (cmp == CmpGt) gt_##S((T*)r->data,(T*)a->data,(T)s,a->size); \
+    else                   ge_##S((T*)r->data,(T*)a->data,(T)s,a->size);
+
+/**
+ * Tells whether `s` does not fit in the elements of `type`, the kernels cannot compare with it then,
+ * but every element compares the same way with it, which is given through `all`
+ */
+static bool out_of_range(DataType type, ArrayCmp cmp, int64_t s, bool* all) {
+    if (BasikArray::fits(type,s)) return false;
+    // Every element is below a scalar above the range, and above one below it
+    if (s > 0)  *all = cmp == CmpNe || cmp == CmpLt || cmp == CmpLe;
+    else        *all = cmp == CmpNe || cmp == CmpGt || cmp == CmpGe;
+    return true;
+}
+
+BasikArray* array_compare(BasikArray* a, ArrayCmp cmp, int64_t s) {
+    BasikArray* r = new BasikArray(a->type,a->size);
+    bool all;
+    if (out_of_range(a->type,cmp,s,&all)) {
+        if (all) for (size_t i = 0; i < a->size; i++) r->set(i,1);
+        return r;
+    }
+         if (a->type == DataType::I16) { BASIK_ARRAY_COMPARE(int16_t,i16) }
+    else if (a->type == DataType::I32) { BASIK_ARRAY_COMPARE(int32_t,i32) }
+    else                               { BASIK_ARRAY_COMPARE(int64_t,i64) }
+    return r;
+}
+
+BasikArray* array_filter(BasikArray* a, ArrayCmp cmp, int64_t s) {
+    BasikArray* r = new BasikArray(a->type,a->size);
+    bool all;
+    if (out_of_range(a->type,cmp,s,&all)) {
+        if (all) memcpy(r->data,a->data,a->size*BasikArray::elem_size(a->type));
+        else r->size = 0;
+        return r;
+    }
+         if (a->type == DataType::I16) r->size = filter((int16_t*)r->data,(int16_t*)a->data,cmp,(int16_t)s,a->size);
+    else if (a->type == DataType::I32) r->size = filter((int32_t*)r->data,(int32_t*)a->data,cmp,(int32_t)s,a->size);
+    else                               r->size = filter((int64_t*)r->data,(int64_t*)a->data,cmp,s,a->size);
+    return r;
+}
+
+const char* array_isa() {
+#if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__) && !defined(__clang__)
+    return __builtin_cpu_supports("avx2") ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+/********************************\
+*            Builtins            *
+\********************************/
+
+/**
+ * Reads the type name given to `array`
+ */
+static bool parse_elem_type(basik_val* v, DataType* out) {
+    if (v == nullptr || v->type != DataType::String) return false;
+    BasikString* s = (BasikString*)v->data;
+    if (s->len == 4 && !memcmp(s->data,"i16",3)) *out = DataType::I16;
+    else if (s->len == 4 && !memcmp(s->data,"i32",3)) *out = DataType::I32;
+    else if (s->len == 4 && !memcmp(s->data,"i64",3)) *out = DataType::I64;
+    else return false;
+    return true;
+}
+
+static bool parse_cmp(basik_val* v, ArrayCmp* out) {
+    if (v == nullptr || v->type != DataType::String) return false;
+    BasikString* s = (BasikString*)v->data;
+    const char* ops[] = { "==", "!=", "<", "<=", ">", ">=" };
+    for (size_t i = 0; i < sizeof(ops)/sizeof(const char*); i++) {
+        if (s->len-1 == strlen(ops[i]) && !memcmp(s->data,ops[i],s->len-1)) {
+            *out = (ArrayCmp)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+Result basik_std_len(Code* code, size_t argc, basik_val** argv) {
+    if (argc != 1) return builtin_error(code,"len() takes 1 argument (%zu given)",argc);
+    basik_val* v = argv[0];
+    int64_t n;
+         if (v != nullptr && v->type == DataType::String) n = ((BasikString*)v->data)->len-1;
+    else if (v != nullptr && v->type == DataType::List)   n = ((BasikList*)v->data)->size;
+    else if (v != nullptr && v->type == DataType::Dict)   n = ((BasikDict*)v->data)->size;
+    else if (v != nullptr && v->type == DataType::Array)  n = ((BasikArray*)v->data)->size;
+    else return builtin_error(code,"len() does not support `%s`",type_name(v));
+    return Result{nullptr,val_i64(n)};
+}
+
+Result basik_std_array(Code* code, size_t argc, basik_val** argv) {
+    if (argc < 1 || argc > 2) return builtin_error(code,"array() takes 1 or 2 arguments (%zu given)",argc);
+    DataType type = DataType::I64;
+    if (argc > 1 && !parse_elem_type(argv[1],&type)) return builtin_error(code,"array() expects 'i16', 'i32' or 'i64' as its type");
+    basik_val* v = argv[0];
+    int64_t n;
+    BasikArray* r;
+    if (v != nullptr && v->type == DataType::List) {
+        BasikList* l = (BasikList*)v->data;
+        r = BasikArray::create(type,l->size);
+        if (r == nullptr) return builtin_error(code,"array() of %zu elements is too large",l->size);
+        for (size_t i = 0; i < l->size; i++) {
+            int64_t e;
+            if (!int_value((*l)[i],&e)) {
+                delete r;
+                return builtin_error(code,"array() expects a List of integers, got `%s` at %zu",type_name((*l)[i]),i);
+            }
+            if (!BasikArray::fits(type,e)) {
+                delete r;
+                return builtin_error(code,"array() cannot store %lld in an Array of %s (at %zu)",(long long)e,get_data_type_str(type),i);
+            }
+            r->set(i,e);
+        }
+    } else if (v != nullptr && v->type == DataType::Array) {
+        BasikArray* a = (BasikArray*)v->data;
+        r = BasikArray::create(type,a->size);
+        if (r == nullptr) return builtin_error(code,"array() of %zu elements is too large",a->size);
+        for (size_t i = 0; i < a->size; i++) {
+            if (!BasikArray::fits(type,a->get(i))) {
+                delete r;
+                return builtin_error(code,"array() cannot store %lld in an Array of %s (at %zu)",(long long)a->get(i),get_data_type_str(type),i);
+            }
+            r->set(i,a->get(i));
+        }
+    } else if (int_value(v,&n)) {
+        if (n < 0) return builtin_error(code,"array() size must not be negative, got %lld",(long long)n);
+        r = BasikArray::create(type,n);
+        if (r == nullptr) return builtin_error(code,"array() of %lld elements is too large",(long long)n);
+    } else
+        return builtin_error(code,"array() expects a List, an Array or a size, got `%s`",type_name(v));
+    return Result{nullptr,new basik_val{DataType::Array,r}};
+}
+
+/**
+ * Implements `sum`, `min` and `max`
+ */
+static Result reduce(Code* code, size_t argc, basik_val** argv, const char* name, int64_t(*fn)(BasikArray*), bool needs_elements) {
+    if (argc != 1) return builtin_error(code,"%s() takes 1 argument (%zu given)",name,argc);
+    if (argv[0] == nullptr || argv[0]->type != DataType::Array) return builtin_error(code,"%s() expects an Array, got `%s`",name,type_name(argv[0]));
+    BasikArray* a = (BasikArray*)argv[0]->data;
+    if (needs_elements && a->size == 0) return builtin_error(code,"%s() of an empty Array",name);
+    return Result{nullptr,val_i64(fn(a))};
+}
+
+Result basik_std_sum(Code* code, size_t argc, basik_val** argv) {
+    if (argc == 1 && argv[0] != nullptr && argv[0]->type == DataType::List) return list_sum(code,(BasikList*)argv[0]->data);
+    return reduce(code,argc,argv,"sum",array_sum,false);
+}
+
+Result basik_std_min(Code* code, size_t argc, basik_val** argv) {
+    return reduce(code,argc,argv,"min",array_min,true);
+}
+
+Result basik_std_max(Code* code, size_t argc, basik_val** argv) {
+    return reduce(code,argc,argv,"max",array_max,true);
+}
+
+/**
+ * Implements `compare` and `filter`, which both take an array, a comparison operator and a scalar
+ */
+static Result compare_args(Code* code, size_t argc, basik_val** argv, const char* name, BasikArray** a, ArrayCmp* cmp, int64_t* s) {
+    if (argc != 3) return builtin_error(code,"%s() takes 3 arguments (%zu given)",name,argc);
+    if (argv[0] == nullptr || argv[0]->type != DataType::Array) return builtin_error(code,"%s() expects an Array, got `%s`",name,type_name(argv[0]));
+    if (!parse_cmp(argv[1],cmp)) return builtin_error(code,"%s() expects '==', '!=', '<', '<=', '>' or '>=' as its operator",name);
+    if (!int_value(argv[2],s)) return builtin_error(code,"%s() expects an integer to compare with, got `%s`",name,type_name(argv[2]));
+    *a = (BasikArray*)argv[0]->data;
+    return Result{nullptr,nullptr};
+}
+
+Result basik_std_compare(Code* code, size_t argc, basik_val** argv) {
+    BasikArray* a = nullptr; ArrayCmp cmp = CmpEq; int64_t s = 0;
+    Result r = compare_args(code,argc,argv,"compare",&a,&cmp,&s);
+    if (r.except != nullptr) return r;
+    return Result{nullptr,new basik_val{DataType::Array,array_compare(a,cmp,s)}};
+}
+
+Result basik_std_filter(Code* code, size_t argc, basik_val** argv) {
+    if (argc == 2 && argv[0] != nullptr && argv[0]->type == DataType::Function && argv[1] != nullptr && argv[1]->type == DataType::List)
+        return list_filter(code,(BasikFunction*)argv[0]->data,(BasikList*)argv[1]->data);
+    BasikArray* a = nullptr; ArrayCmp cmp = CmpEq; int64_t s = 0;
+    Result r = compare_args(code,argc,argv,"filter",&a,&cmp,&s);
+    if (r.except != nullptr) return r;
+    return Result{nullptr,new basik_val{DataType::Array,array_filter(a,cmp,s)}};
+}
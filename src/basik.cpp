@@ -0,0 +1,1760 @@
+#include "basik.h"
+#include "ops.h"
+
+#include <new>
+#include <time.h>
+
+#if defined(__linux__)
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+/********************************\ 
+* Implementations for the header *
+\********************************/
+
+// Basic Data Structures //
+
+basik_val::~basik_val() {
+         if (this->type == DataType::Char)     delete ((BasikChar*)      this->data);
+    else if (this->type == DataType::I16)      delete ((BasikI16*)       this->data);
+    else if (this->type == DataType::I32)      delete ((BasikI32*)       this->data);
+    else if (this->type == DataType::I64)      delete ((BasikI64*)       this->data);
+    else if (this->type == DataType::String)   delete ((BasikString*)    this->data);
+    else if (this->type == DataType::List)     delete ((BasikList*)      this->data);
+    else if (this->type == DataType::Function) delete ((BasikFunction*)  this->data);
+    else if (this->type == DataType::Bool)     delete ((BasikBool*)      this->data);
+    else if (this->type == DataType::File)     delete ((BasikFile*)      this->data);
+    else if (this->type == DataType::Dict)     delete ((BasikDict*)      this->data);
+    else if (this->type == DataType::Array)    delete ((BasikArray*)     this->data);
+    else {
+        fprintf(stderr,"Attempt to destroy unsupported `%s` (%u)\n",get_data_type_str(this->type),this->type);
+        exit(1);
+    }
+}
+
+// Types Data Structures //
+
+// Char
+BasikChar::BasikChar(uint8_t data) {
+    this->data = new uint8_t(data);
+}
+BasikChar::~BasikChar() {
+    delete this->data;
+}
+
+// I16
+BasikI16::BasikI16(int16_t data) {
+    this->data = new int16_t(data);
+}
+BasikI16::~BasikI16() {
+    delete this->data;
+}
+
+// I32
+BasikI32::BasikI32(int32_t data) {
+    this->data = new int32_t(data);
+}
+BasikI32::~BasikI32() {
+    delete this->data;
+}
+
+// I64
+BasikI64::BasikI64(int64_t data) {
+    this->data = new int64_t(data);
+}
+BasikI64::~BasikI64() {
+    delete this->data;
+}
+
+// String
+BasikString::BasikString(size_t len, const char* data) {
+    uint8_t* d = new uint8_t[len+1];
+    memcpy(d,data,len);
+    d[len-1] = 0;
+    this->data = d;
+    this->len = len;
+    this->hash = 0;
+    this->interned = false;
+    this->owned = true;
+    this->buf = nullptr;
+}
+BasikString::BasikString(size_t len, const char* data, uint64_t hash) {
+    this->data = (const uint8_t*)data;
+    this->len = len;
+    this->hash = hash;
+    this->interned = true;
+    this->owned = false;
+    this->buf = nullptr;
+}
+BasikString::~BasikString() {
+    if (this->buf != nullptr)
+        BasikStringBuf::release(this->buf);
+    else if (this->owned)
+        delete[] this->data;
+    this->len = 0;
+}
+BasikString* BasikString::view(BasikStringBuf* buf, size_t off, size_t sz) {
+    BasikString* s = new BasikString(sz+1,(const char*)buf->data+off,0);
+    s->interned = false;
+    s->buf = buf;
+    buf->refs++;
+    return s;
+}
+BasikString* BasikString::take(size_t len, uint8_t* data) {
+    BasikString* s = new BasikString(len,(const char*)data,0);
+    s->interned = false;
+    s->owned = true;
+    return s;
+}
+BasikString* BasikString::slice(size_t off, size_t sz) {
+    if (this->owned) {
+        BasikStringBuf* b = BasikStringBuf::create(this->len,false);
+        memcpy(b->data,this->data,this->len);
+        b->used = this->len-1;
+        delete[] this->data;
+        this->data = b->data;
+        this->buf = b;
+        this->owned = false;
+    }
+    if (this->buf != nullptr) return BasikString::view(this->buf,this->data+off-this->buf->data,sz);
+    // Interned strings live as long as the program, so their slices can simply borrow their data
+    BasikString* s = new BasikString(sz+1,(const char*)this->data+off,0);
+    s->interned = false;
+    return s;
+}
+int64_t BasikString::find(BasikString* sub, size_t from) {
+    size_t n = this->len-1, m = sub->len-1;
+    if (m == 0) return from <= n ? (int64_t)from : -1;
+    if (from >= n || m > n-from) return -1;
+    const uint8_t* p = this->data+from;
+    const uint8_t* e = this->data+n-m+1;
+    // memchr finds the candidates a lot faster than comparing at every position
+    while (p < e && (p = (const uint8_t*)memchr(p,sub->data[0],e-p)) != nullptr) {
+        if (!memcmp(p,sub->data,m)) return p-this->data;
+        p++;
+    }
+    return -1;
+}
+basik_val* BasikString::concat(basik_val* a, basik_val* b) {
+    BasikString* sa = (BasikString*)a->data;
+    BasikString* sb = (BasikString*)b->data;
+    size_t len = sa->len + sb->len - 1;
+    BasikStringBuf* buf = sa->buf;
+    if (buf != nullptr && buf->appendable && sa->data+sa->len-1 == buf->data+buf->used && buf->used+sb->len <= buf->cap) {
+        memcpy(buf->data+buf->used,sb->data,sb->len-1);
+        buf->used += sb->len-1;
+        buf->data[buf->used] = 0;
+        return new basik_val{DataType::String,BasikString::view(buf,buf->used-(len-1),len-1)};
+    }
+    buf = BasikStringBuf::create(len*2 < 64 ? 64 : len*2,true);
+    memcpy(buf->data,sa->data,sa->len-1);
+    memcpy(buf->data+sa->len-1,sb->data,sb->len-1);
+    buf->used = len-1;
+    buf->data[buf->used] = 0;
+    BasikString* s = BasikString::view(buf,0,len-1);
+    // The string is now the only one holding the buffer
+    BasikStringBuf::release(buf);
+    return new basik_val{DataType::String,s};
+}
+uint64_t BasikString::hash_of(size_t len, const char* data) {
+    // FNV-1a
+    uint64_t h = 14695981039346656037llu;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)data[i];
+        h *= 1099511628211llu;
+    }
+    return h;
+}
+bool BasikString::equals(BasikString* a, BasikString* b) {
+    if (a == b) return true;
+    if (a->interned && b->interned) return false;
+    return a->len == b->len && !memcmp(a->data,b->data,a->len-1);
+}
+
+BasikStringBuf* BasikStringBuf::create(size_t cap, bool appendable) {
+    BasikStringBuf* buf = (BasikStringBuf*)malloc(sizeof(BasikStringBuf)+cap);
+    buf->refs = 1;
+    buf->cap = cap;
+    buf->used = 0;
+    buf->appendable = appendable;
+    buf->mapped = false;
+    buf->data = (uint8_t*)(buf+1);
+    return buf;
+}
+BasikStringBuf* BasikStringBuf::map(void* mem, size_t sz) {
+    BasikStringBuf* buf = (BasikStringBuf*)malloc(sizeof(BasikStringBuf));
+    buf->refs = 1;
+    buf->cap = sz;
+    buf->used = sz;
+    buf->appendable = false;
+    buf->mapped = true;
+    buf->data = (uint8_t*)mem;
+    return buf;
+}
+void BasikStringBuf::release(BasikStringBuf* buf) {
+    if (--buf->refs) return;
+#if defined(__linux__)
+    if (buf->mapped) munmap(buf->data,buf->cap);
+#endif
+    free(buf);
+}
+
+// List
+BasikList::BasikList() {
+    this->buf = new BasikListBuf();
+    this->off = 0;
+    this->size = 0;
+}
+BasikList::BasikList(BasikList* from, size_t off, size_t size) {
+    this->buf = from->buf;
+    this->buf->refs++;
+    this->off = from->off+off;
+    this->size = size;
+}
+BasikList::~BasikList() {
+    if (--this->buf->refs == 0) delete this->buf;
+}
+void BasikList::own(gc_t* gc) {
+    if (this->buf->refs == 1 && this->off == 0 && this->size == this->buf->items.size) return;
+    BasikListBuf* buf = new BasikListBuf();
+    buf->items.reserve(this->size);
+    memcpy(buf->items.data,this->items(),this->size*sizeof(basik_val*));
+    buf->items.size = this->size;
+    for (size_t i = 0; i < this->size; i++) gc->add_ref(buf->items.data[i]);
+    // No other list uses the old storage anymore, the references it held are given back (see `gc_t::collect`)
+    if (--this->buf->refs == 0) {
+        for (size_t i = 0; i < this->buf->items.size; i++) gc->remove_ref(this->buf->items.data[i]);
+        delete this->buf;
+    }
+    this->buf = buf;
+    this->off = 0;
+}
+void BasikList::append(basik_val* v) {
+    this->buf->items.push(v);
+    this->size++;
+}
+void BasikList::reserve(size_t cap) {
+    this->buf->items.reserve(this->off+cap);
+}
+void BasikList::set(gc_t* gc, size_t i, basik_val* v) {
+    gc->add_ref(v);
+    gc->remove_ref(this->items()[i]);
+    this->items()[i] = v;
+}
+
+// Function
+BasikFunction::BasikFunction(Code* code) {
+    this->code = code;
+    this->callback = nullptr;
+}
+BasikFunction::BasikFunction(Result(*callback)(Code*,size_t,basik_val**)) {
+    this->callback = callback;
+    this->code = nullptr;
+}
+BasikFunction::~BasikFunction() {
+
+}
+
+// Dict
+BasikDict::BasikDict(gc_t* gc, size_t size) {
+    this->gc = gc;
+    this->cap = 8;
+    // Keeps the load factor under 3/4
+    while (this->cap*3 < size*4) this->cap *= 2;
+    this->slots = new slot[this->cap]();
+    this->size = 0;
+}
+BasikDict::~BasikDict() {
+    for (size_t i = 0; i < this->cap; i++) {
+        slot& sl = this->slots[i];
+        if (sl.key == nullptr) continue;
+        this->gc->remove_ref(sl.key);
+        this->gc->remove_ref(sl.value);
+    }
+    delete[] this->slots;
+}
+bool BasikDict::hashable(basik_val* key) {
+    if (key == nullptr) return false;
+    return key->type == DataType::String || key->type == DataType::Char || key->type == DataType::I16 || key->type == DataType::I32
+        || key->type == DataType::I64 || key->type == DataType::Bool || key->type == DataType::Function;
+}
+uint64_t BasikDict::hash_of(basik_val* key) {
+    uint64_t h;
+    if (key->type == DataType::String) {
+        BasikString* s = (BasikString*)key->data;
+        // The terminator is left out, views do not own the byte after their data
+        if (s->hash == 0) s->hash = BasikString::hash_of(s->len-1,(const char*)s->data);
+        return s->hash;
+    }
+         if (key->type == DataType::Char)     h = *((BasikChar*)key->data)->data;
+    else if (key->type == DataType::I16)      h = *((BasikI16*)key->data)->data;
+    else if (key->type == DataType::I32)      h = *((BasikI32*)key->data)->data;
+    else if (key->type == DataType::I64)      h = *((BasikI64*)key->data)->data;
+    else if (key->type == DataType::Bool)     h = *((BasikBool*)key->data)->data;
+    else                                      h = (uintptr_t)((BasikFunction*)key->data)->code ^ (uintptr_t)((BasikFunction*)key->data)->callback;
+    // Spreads the bits of small integers over the whole hash (splitmix64)
+    h += key->type;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9llu;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebllu;
+    return h ^ (h >> 31);
+}
+bool BasikDict::key_equals(basik_val* a, basik_val* b) {
+    if (a == b) return true;
+    if (a->type != b->type) return false;
+    if (a->type == DataType::String)   return BasikString::equals((BasikString*)a->data,(BasikString*)b->data);
+    if (a->type == DataType::Char)     return *((BasikChar*)a->data)->data == *((BasikChar*)b->data)->data;
+    if (a->type == DataType::I16)      return *((BasikI16*)a->data)->data  == *((BasikI16*)b->data)->data;
+    if (a->type == DataType::I32)      return *((BasikI32*)a->data)->data  == *((BasikI32*)b->data)->data;
+    if (a->type == DataType::I64)      return *((BasikI64*)a->data)->data  == *((BasikI64*)b->data)->data;
+    if (a->type == DataType::Bool)     return *((BasikBool*)a->data)->data == *((BasikBool*)b->data)->data;
+    if (a->type == DataType::Function) return ((BasikFunction*)a->data)->code == ((BasikFunction*)b->data)->code && ((BasikFunction*)a->data)->callback == ((BasikFunction*)b->data)->callback;
+    return false;
+}
+BasikDict::slot* BasikDict::probe(basik_val* key, uint64_t hash) {
+    size_t i = hash & (this->cap-1);
+    for (;; i = (i+1) & (this->cap-1)) {
+        slot& sl = this->slots[i];
+        if (sl.key == nullptr || (sl.hash == hash && BasikDict::key_equals(sl.key,key))) return &sl;
+    }
+}
+BasikDict::slot* BasikDict::find(basik_val* key) {
+    slot* sl = this->probe(key,BasikDict::hash_of(key));
+    return sl->key == nullptr ? nullptr : sl;
+}
+void BasikDict::set(basik_val* key, basik_val* value) {
+    uint64_t h = BasikDict::hash_of(key);
+    slot* sl = this->probe(key,h);
+    this->gc->add_ref(value);
+    if (sl->key != nullptr) {
+        this->gc->remove_ref(sl->value);
+        sl->value = value;
+        return;
+    }
+    this->gc->add_ref(key);
+    *sl = slot{h,key,value};
+    if (++this->size*4 > this->cap*3) this->grow();
+}
+void BasikDict::grow() {
+    slot* old = this->slots;
+    size_t old_cap = this->cap;
+    this->cap *= 2;
+    this->slots = new slot[this->cap]();
+    for (size_t i = 0; i < old_cap; i++) {
+        if (old[i].key == nullptr) continue;
+        size_t j = old[i].hash & (this->cap-1);
+        while (this->slots[j].key != nullptr) j = (j+1) & (this->cap-1);
+        this->slots[j] = old[i];
+    }
+    delete[] old;
+}
+
+// File
+BasikFile::BasikFile(FILE* file) {
+    this->in = new Input(file,65536);
+}
+BasikFile::~BasikFile() {
+    fclose(this->in->file);
+    delete this->in;
+}
+
+// Bool
+BasikBool::BasikBool(bool data) {
+    this->data = new bool(data);
+}
+BasikBool::~BasikBool() {
+    delete this->data;
+}
+
+// Other Data Structures //
+
+Buffer::Buffer(size_t size) {
+    this->data = this->_data = (uint8_t*)malloc(size);
+    this->size = this->_size = size;
+}
+
+Buffer::Buffer(size_t size, void* data) {
+    this->data = this->_data = (uint8_t*)malloc(size);
+    this->size = this->_size = size;
+    memcpy(this->data,data,size);
+}
+
+Buffer::~Buffer() {
+    free(this->_data);
+}
+
+gc_t::gc_t() {
+    this->refs = new Stack<gc_ref>(256);
+    this->index_cap = 512;
+    this->index = new size_t[this->index_cap]();
+    this->allocs = 0;
+}
+
+gc_t::~gc_t() {
+    // Freeing a dict gives back the references of its entries, which only lowers their count since they are freed here as well
+    while (this->refs->size) {
+        basik_val* v = this->refs->data[this->refs->size-1].v;
+        this->erase(this->refs->size-1,this->slot_of(v));
+        delete v;
+    }
+    delete this->refs;
+    delete[] this->index;
+}
+
+/********************************\
+*           Exceptions           *
+\********************************/
+
+// The exceptions that were deleted, reused by the next ones of the same thread
+static thread_local Stack<void*> free_exceptions;
+
+void* BasikException::operator new(size_t sz) {
+    void* p = free_exceptions.pop();
+    return p != nullptr ? p : malloc(sz);
+}
+
+void BasikException::operator delete(void* p) {
+    free_exceptions.push(p);
+}
+
+BASIK_COLD BasikException::BasikException(const char* text, size_t origin, Code* origin_code) {
+    BASIK_PROBE3(exception,text,origin,origin_code);
+    this->text = text;
+    this->frames = this->inline_frames;
+    this->tracecap = INLINE_FRAMES;
+    this->frames[0] = frame{origin,origin_code};
+    this->traci = 1;
+}
+
+BASIK_COLD BasikException::BasikException(size_t origin, Code* origin_code, const char* fmt, ...) {
+    this->frames = this->inline_frames;
+    this->tracecap = INLINE_FRAMES;
+    this->frames[0] = frame{origin,origin_code};
+    this->traci = 1;
+    va_list args;
+    va_start(args,fmt);
+    this->set_text(fmt,args);
+    va_end(args);
+    BASIK_PROBE3(exception,this->text,origin,origin_code);
+}
+
+BasikException::~BasikException() {
+    if (this->frames != this->inline_frames) free(this->frames);
+}
+
+void BasikException::set_text(const char* fmt, va_list args) {
+    if (strchr(fmt,'%') == nullptr) {
+        this->text = fmt;
+        return;
+    }
+    vsnprintf(this->buf,sizeof(this->buf),fmt,args);
+    this->text = this->buf;
+}
+
+BASIK_COLD void BasikException::grow() {
+    size_t cap = this->tracecap*2;
+    frame* f = (frame*)malloc(cap*sizeof(frame));
+    memcpy(f,this->frames,this->traci*sizeof(frame));
+    if (this->frames != this->inline_frames) free(this->frames);
+    this->frames = f;
+    this->tracecap = cap;
+}
+
+// Spreads the addresses of values over the whole index, their low bits are always the same
+static inline size_t gc_hash(basik_val* v) {
+    uint64_t h = (uintptr_t)v;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdllu;
+    h ^= h >> 33;
+    return h;
+}
+
+size_t* gc_t::slot_of( basik_val* v ) {
+    size_t mask = this->index_cap-1;
+    for (size_t i = gc_hash(v) & mask;; i = (i+1) & mask) {
+        size_t p = this->index[i];
+        if (p == 0 || this->refs->data[p-1].v == v) return &this->index[i];
+    }
+}
+
+void gc_t::erase( size_t pos, size_t* slot ) {
+    // The entries after the slot that would be reached from before it are moved back (backward shift deletion)
+    size_t mask = this->index_cap-1;
+    size_t i = slot-this->index;
+    for (size_t j = (i+1) & mask; this->index[j] != 0; j = (j+1) & mask) {
+        size_t home = gc_hash(this->refs->data[this->index[j]-1].v) & mask;
+        if (((j-home) & mask) >= ((j-i) & mask)) {
+            this->index[i] = this->index[j];
+            i = j;
+        }
+    }
+    this->index[i] = 0;
+    size_t last = this->refs->size-1;
+    if (pos != last) {
+        *this->slot_of(this->refs->data[last].v) = pos+1;
+        this->refs->data[pos] = this->refs->data[last];
+    }
+    this->refs->size--;
+}
+
+bool gc_t::add_ref_ex( basik_val* v, size_t* count ) {
+    if (v == nullptr) return false;
+    if (is_immortal(v)) {
+        if (count != nullptr) *count = 1;
+        return false;
+    }
+    size_t* slot = this->slot_of(v);
+    if (*slot != 0) {
+        gc_ref& r = this->refs->data[*slot-1];
+        r.c++;
+        // printf("\t\t\t\tGC ADD %p %zu\n",v,r.c);
+        if (count != nullptr) *count = r.c;
+        return false;
+    }
+    // printf("\t\t\t\tGC NEW %p 1\n",v);
+    if (count != nullptr) *count = 1;
+    this->refs->push(gc_ref{v,1});
+    *slot = this->refs->size;
+    this->allocs++;
+    // Keeps the load factor of the index under 1/2
+    if (this->refs->size*2 > this->index_cap) {
+        delete[] this->index;
+        this->index_cap *= 2;
+        this->index = new size_t[this->index_cap]();
+        for (size_t i = 0; i < this->refs->size; i++) *this->slot_of(this->refs->data[i].v) = i+1;
+    }
+    return true;
+}
+
+bool gc_t::add_ref( basik_val* v ) {
+    if (v == nullptr) return false;
+    return add_ref_ex(v,nullptr);
+}
+
+bool gc_t::remove_ref( basik_val* v ) {
+    if (is_immortal(v)) return true;
+    if (v == nullptr) return false;
+    size_t p = *this->slot_of(v);
+    if (p == 0) return false;
+    gc_ref& r = this->refs->data[p-1];
+    if (r.c && --r.c == 0) this->dead.push(v);
+    // printf("\t\t\t\tGC REM %p %zu\n",r.v,r.c);
+    return true;
+}
+ 
+size_t gc_t::collect( void ) {
+    if (this->dead.size == 0) return 0;
+    size_t c = 0;
+    // Freeing a list can release its elements, which are added to `dead` while it is gone through
+    for (size_t d = 0; d < this->dead.size; d++) {
+        basik_val* v = this->dead.data[d];
+        // The value may have been referenced again since, or be there twice
+        size_t* slot = this->slot_of(v);
+        if (*slot == 0 || this->refs->data[*slot-1].c != 0) continue;
+        // printf("\t\t\t\tGC COL %p\n",v);
+        // The storage of a list holds a reference to its elements, which it gives back once no list uses it anymore
+        if (v->type == DataType::List && ((BasikList*)v->data)->buf->refs == 1) {
+            Stack<basik_val*>& items = ((BasikList*)v->data)->buf->items;
+            for (size_t j = 0; j < items.size; j++) this->remove_ref(items.data[j]);
+            slot = this->slot_of(v);
+        }
+        this->erase(*slot-1,slot);
+        delete v;
+        c++;
+    }
+    this->dead.size = 0;
+    if (c) BASIK_PROBE2(gc__collect,c,this->refs->size);
+    return c;
+}
+
+StringTable::StringTable(gc_t* gc) {
+    this->gc = gc;
+    this->cap = 64;
+    this->size = 0;
+    this->slots = new basik_val*[this->cap]();
+}
+
+StringTable::~StringTable() {
+    delete[] this->slots;
+}
+
+basik_val* StringTable::intern(size_t len, const char* data) {
+    // Hashed the same way as dict keys (see `BasikDict::hash_of`), so the hash can be reused by lookups
+    uint64_t h = BasikString::hash_of(len-1,data);
+    size_t i = h & (this->cap-1);
+    for (basik_val* v; (v = this->slots[i]) != nullptr; i = (i+1) & (this->cap-1)) {
+        BasikString* s = (BasikString*)v->data;
+        if (s->hash == h && s->len == len && !memcmp(s->data,data,len-1)) return v;
+    }
+    basik_val* v = new basik_val{DataType::String,new BasikString(len,data,h)};
+    this->gc->add_ref(v);
+    this->slots[i] = v;
+    // Keeps the load factor under 1/2
+    if (++this->size*2 > this->cap) {
+        basik_val** old = this->slots;
+        size_t old_cap = this->cap;
+        this->cap *= 2;
+        this->slots = new basik_val*[this->cap]();
+        for (size_t j = 0; j < old_cap; j++) {
+            if (old[j] == nullptr) continue;
+            size_t k = ((BasikString*)old[j]->data)->hash & (this->cap-1);
+            while (this->slots[k] != nullptr) k = (k+1) & (this->cap-1);
+            this->slots[k] = old[j];
+        }
+        delete[] old;
+    }
+    return v;
+}
+
+/********************************\ 
+*           Main stuff           *
+\********************************/
+
+// Profiler
+
+Profiler::Profiler(gc_t* gc) {
+    this->gc = gc;
+    this->cur_code = nullptr;
+    this->cur_file = nullptr;
+    this->cur = nullptr;
+    this->t = 0;
+    this->allocs = 0;
+}
+
+uint64_t Profiler::now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000llu + (uint64_t)ts.tv_nsec;
+}
+
+Profiler::prof_file* Profiler::get_file(const char* source) {
+    for (size_t i = 0; i < files.size; i++)
+        if (!strcmp(files.data[i]->source,source)) return files.data[i];
+    prof_file* f = new prof_file{source,{}};
+    files.push(f);
+    return f;
+}
+
+Profiler::prof_line* Profiler::get_line(prof_file* f, uint32_t line) {
+    while (f->lines.size <= line) f->lines.push(nullptr);
+    prof_line* &l = f->lines.data[line];
+    if (l == nullptr) l = new prof_line{0,0,0};
+    return l;
+}
+
+void Profiler::flush() {
+    uint64_t n = now();
+    if (cur != nullptr) {
+        cur->ns += n-t;
+        cur->allocs += gc->allocs-allocs;
+    }
+    t = n;
+    allocs = gc->allocs;
+}
+
+void Profiler::step(Code* code, size_t addr) {
+    flush();
+    if (code != cur_code) {
+        const char* source = code->get_source();
+        cur_file = get_file(source == nullptr ? "<unknown>" : source);
+        cur_code = code;
+    }
+    cur = get_line(cur_file,code->line_map_get(addr));
+    cur->instrs++;
+}
+
+void Profiler::report(FILE* out) {
+    flush();
+    cur = nullptr;
+    for (size_t i = 0; i < files.size; i++) {
+        prof_file* f = files.data[i];
+        uint64_t total = 0;
+        for (size_t l = 0; l < f->lines.size; l++)
+            if (f->lines.data[l] != nullptr) total += f->lines.data[l]->ns;
+        // Tries to show the source next to the numbers
+        char* src = nullptr;
+        FILE* sf = fopen(f->source,"r");
+        if (sf != nullptr) {
+            fseek(sf,0,SEEK_END);
+            long sz = ftell(sf);
+            fseek(sf,0,SEEK_SET);
+            src = new char[sz+1];
+            src[fread(src,1,sz,sf)] = 0;
+            fclose(sf);
+        }
+        fprintf(out,"Line profile of `%s` (%.3f ms):\n",f->source,total/1e6);
+        fprintf(out,"%6s %12s %12s %7s %10s  %s\n","Line","Instrs","Time (ms)","%","Allocs","Source");
+        const char* sl = src;
+        for (size_t l = 0; l < f->lines.size; l++) {
+            // Finds the text of the line
+            const char* se = sl;
+            size_t sn = 0;
+            if (sl != nullptr && l > 0) {
+                while (*se && *se != '\n') se++;
+                sn = se-sl;
+            }
+            prof_line* pl = f->lines.data[l];
+            if (pl != nullptr)
+                fprintf(out,"%6zu %12" PRIu64 " %12.3f %6.2f%% %10zu  %.*s\n",l,pl->instrs,pl->ns/1e6,total?pl->ns*100.0/total:0.0,pl->allocs,(int)sn,l>0&&sl?sl:"");
+            if (sl != nullptr && l > 0) sl = *se ? se+1 : se;
+        }
+        delete[] src;
+    }
+}
+
+// Perf
+
+vm_frame* volatile basik_frame_top = nullptr;
+
+Perf::Perf() {
+    this->mem = nullptr;
+    this->mem_sz = 0;
+}
+
+bool Perf::load(Stack<CodeObj*>* objects) {
+#if defined(__linux__) && defined(__x86_64__)
+    // push rbp; mov rbp, rsp; call rsi; pop rbp; ret
+    static const uint8_t tramp[] = { 0x55, 0x48, 0x89, 0xe5, 0xff, 0xd6, 0x5d, 0xc3 };
+    const size_t tramp_sz = 16;
+    mem_sz = objects->size*tramp_sz;
+    if (mem_sz == 0) return true;
+    mem = (uint8_t*)mmap(nullptr,mem_sz,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+    if (mem == MAP_FAILED) {
+        mem = nullptr;
+        return false;
+    }
+    char map_path[64];
+    snprintf(map_path,sizeof(map_path),"/tmp/perf-%d.map",(int)getpid());
+    FILE* map = fopen(map_path,"a");
+    for (size_t i = 0; i < objects->size; i++) {
+        CodeObj* obj = objects->data[i];
+        uint8_t* t = mem+i*tramp_sz;
+        memset(t,0xcc,tramp_sz);
+        memcpy(t,tramp,sizeof(tramp));
+        obj->code->trampoline = (Result(*)(Code*,Result(*)(Code*)))t;
+        if (map != nullptr) fprintf(map,"%" PRIxPTR " %zx basik::%s\n",(uintptr_t)t,tramp_sz,obj->full_name);
+    }
+    if (map != nullptr) fclose(map);
+    if (mprotect(mem,mem_sz,PROT_READ|PROT_EXEC)) {
+        for (size_t i = 0; i < objects->size; i++) objects->data[i]->code->trampoline = nullptr;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Output
+
+Output::Output(FILE* file, size_t cap) {
+    this->file = file;
+    this->buf = new uint8_t[cap];
+    this->size = 0;
+    this->cap = cap;
+    // Interactive sessions see every line as soon as it is printed
+#if defined(__linux__)
+    this->line_buffered = isatty(fileno(file));
+#else
+    this->line_buffered = false;
+#endif
+}
+
+Output::~Output() {
+    this->flush();
+    delete[] this->buf;
+}
+
+void Output::write(const void* data, size_t sz) {
+    if (this->size+sz > this->cap) {
+        this->flush();
+        // Too big to be buffered anyways
+        if (sz > this->cap) {
+            fwrite(data,1,sz,this->file);
+            return;
+        }
+    }
+    memcpy(this->buf+this->size,data,sz);
+    this->size += sz;
+}
+
+void Output::write_i64(int64_t v) {
+    char d[20];
+    size_t n = 0;
+    // Works on the magnitude as unsigned so that INT64_MIN does not overflow
+    uint64_t u = v < 0 ? 0-(uint64_t)v : (uint64_t)v;
+    do {
+        d[n++] = '0' + u%10;
+        u /= 10;
+    } while (u);
+    if (this->size+n+1 > this->cap) this->flush();
+    if (v < 0) this->buf[this->size++] = '-';
+    while (n) this->buf[this->size++] = d[--n];
+}
+
+void Output::flush() {
+    if (this->size) fwrite(this->buf,1,this->size,this->file);
+    this->size = 0;
+    fflush(this->file);
+}
+
+// Input
+
+Input::Input(FILE* file, size_t cap) {
+    this->file = file;
+    this->block = BasikStringBuf::create(cap,false);
+    this->pos = 0;
+    this->scan = 0;
+    this->eof = false;
+}
+
+Input::~Input() {
+    BasikStringBuf::release(this->block);
+}
+
+bool Input::fill() {
+    BasikStringBuf* b = this->block;
+    size_t rem = b->used-this->pos;
+    // A line longer than half the block, it grows so that moving the unread data stays cheap,
+    // unless nothing was read from the block yet and it still has room, in which case it is only filled up
+    size_t cap = rem*2 > b->cap && (this->pos != 0 || rem == b->cap) ? rem*2 : b->cap;
+    if (b->refs == 1 && cap == b->cap) {
+        // Nothing points into the block, the unread data can simply be moved to its start
+        if (this->pos) memmove(b->data,b->data+this->pos,rem);
+    } else if (b->refs == 1 || this->pos != 0 || rem == b->cap) {
+        BasikStringBuf* nb = BasikStringBuf::create(cap,false);
+        memcpy(nb->data,b->data+this->pos,rem);
+        BasikStringBuf::release(b);
+        this->block = b = nb;
+    }
+    this->scan -= this->pos;
+    this->pos = 0;
+    b->used = rem;
+#if defined(__linux__)
+    // Only waits for what is available, so that interactive sessions get their lines right away
+    ssize_t n = ::read(fileno(this->file),b->data+b->used,b->cap-b->used);
+    if (n < 0) n = 0;
+#else
+    size_t n = fread(b->data+b->used,1,b->cap-b->used,this->file);
+#endif
+    if (n == 0) this->eof = true;
+    b->used += n;
+    return n != 0;
+}
+
+BasikString* Input::readline() {
+    for (;;) {
+        BasikStringBuf* b = this->block;
+        uint8_t* nl = (uint8_t*)memchr(b->data+this->scan,'\n',b->used-this->scan);
+        if (nl != nullptr) {
+            size_t end = nl-b->data+1;
+            BasikString* s = BasikString::view(b,this->pos,end-this->pos);
+            this->pos = this->scan = end;
+            return s;
+        }
+        this->scan = b->used;
+        if (this->eof || !this->fill()) {
+            // The last line may not end with a line break
+            if (this->pos == this->block->used) return nullptr;
+            BasikString* s = BasikString::view(this->block,this->pos,this->block->used-this->pos);
+            this->pos = this->scan = this->block->used;
+            return s;
+        }
+    }
+}
+
+BasikString* Input::read_all() {
+    while (!this->eof) this->fill();
+    BasikString* s = BasikString::view(this->block,this->pos,this->block->used-this->pos);
+    this->pos = this->scan = this->block->used;
+    return s;
+}
+
+/********************************\ 
+*             Globals            *
+\********************************/
+
+static basik_val* create_immortals() {
+    basik_val* v = (basik_val*)malloc(IMMORTAL_COUNT*sizeof(basik_val));
+    for (size_t i = 0; i < 2; i++)               new (&v[IMMORTAL_BOOL+i]) basik_val{DataType::Bool,new BasikBool(i)};
+    for (size_t i = 0; i < 256; i++)             new (&v[IMMORTAL_CHAR+i]) basik_val{DataType::Char,new BasikChar(i)};
+    for (size_t i = 0; i < SMALL_INT_COUNT; i++) new (&v[IMMORTAL_I16+i])  basik_val{DataType::I16,new BasikI16(SMALL_INT_MIN+i)};
+    for (size_t i = 0; i < SMALL_INT_COUNT; i++) new (&v[IMMORTAL_I32+i])  basik_val{DataType::I32,new BasikI32(SMALL_INT_MIN+i)};
+    for (size_t i = 0; i < SMALL_INT_COUNT; i++) new (&v[IMMORTAL_I64+i])  basik_val{DataType::I64,new BasikI64(SMALL_INT_MIN+i)};
+    return v;
+}
+
+basik_val* const immortals = create_immortals();
+Profiler* profiler = nullptr;
+Perf* perf = nullptr;
+
+// The amount of instructions that have been executed
+thread_local uint64_t instr_count = 0;
+
+Result call_code(Code* code) {
+    BASIK_PROBE2(function__entry,code->obj->full_name,code->get_source());
+    Result r;
+    Result(*entry)(Code*) = code->native != nullptr ? code->native : run;
+    if (perf != nullptr) {
+        vm_frame frame{basik_frame_top,code->obj->full_name,code};
+        basik_frame_top = &frame;
+        r = code->trampoline != nullptr ? code->trampoline(code,entry) : entry(code);
+        basik_frame_top = frame.prev;
+    } else
+        r = entry(code);
+    BASIK_PROBE1(function__return,code->obj->full_name);
+    return r;
+}
+
+Result call_code_with(Code* code, basik_val* args) {
+    Result pr = pre_run(code);
+    if (pr.except != nullptr) return pr;
+    Code* c = code->depth ? code->fork() : code;
+    code->depth++;
+    c->dynvar_set("...",args);
+    Result r = call_code(c);
+    code->depth--;
+    // A fork that was left by an exception may still hold values on its stack, so it is not reused,
+    // the object itself is cleaned up instead, since it can still be called again (by isolates or by the host)
+    if (c != code && r.except == nullptr) code->forks.push(c);
+    else if (c == code && r.except != nullptr) {
+        code->list_stack.size = 0;
+        op_leave(code,nullptr);
+    }
+    return r;
+}
+
+size_t instr_size(const uint8_t* p, const uint8_t* end) {
+    size_t sz;
+    switch (*p) {
+        case OpCodes::StoreSimple: case OpCodes::LoadSimple: case OpCodes::PushString: case OpCodes::PushI32: case OpCodes::ListExpand: case OpCodes::Call:
+            sz = 5; break;
+        case OpCodes::PushChar: case OpCodes::PushBool:
+            sz = 2; break;
+        case OpCodes::PushI16:
+            sz = 3; break;
+        case OpCodes::PushI64: case OpCodes::Jump: case OpCodes::JumpIf: case OpCodes::JumpIfNot:
+            sz = 9; break;
+        case OpCodes::JumpIfNotCmp:
+            sz = 10; break;
+        case OpCodes::ForRangeI64:
+            sz = 25; break;
+        case OpCodes::StoreDynamic: case OpCodes::LoadDynamic: case OpCodes::StoreGlobal: case OpCodes::RemoveDynamic: case OpCodes::LoadFunction: case OpCodes::Import: {
+            const uint8_t* e = (const uint8_t*)memchr(p+1,0,end-p-1);
+            if (e == nullptr) return 0;
+            sz = e-p+1;
+            break;
+        }
+        case OpCodes::LoadGlobal: { // The index of its inline cache comes before the name
+            if (end-p < 6) return 0;
+            const uint8_t* e = (const uint8_t*)memchr(p+5,0,end-p-5);
+            if (e == nullptr) return 0;
+            sz = e-p+1;
+            break;
+        }
+        case OpCodes::PushArray: {
+            if (end-p < 6) return 0;
+            DataType type = (DataType)p[1];
+            if (type != DataType::I16 && type != DataType::I32 && type != DataType::I64) return 0;
+            sz = 6+*(uint32_t*)(p+2)*BasikArray::elem_size(type);
+            break;
+        }
+        case OpCodes::End: case OpCodes::ListBegin: case OpCodes::ListEnd: case OpCodes::DictBegin: case OpCodes::DictEnd:
+        case OpCodes::Add: case OpCodes::Sub: case OpCodes::Div: case OpCodes::Mul: case OpCodes::Pop: case OpCodes::Dup:
+        case OpCodes::Return: case OpCodes::PushNull: case OpCodes::Equals: case OpCodes::NotEquals:
+        case OpCodes::Less: case OpCodes::LessEquals: case OpCodes::Greater: case OpCodes::GreaterEquals:
+        case OpCodes::Subscript: case OpCodes::StoreSubscript: case OpCodes::Slice:
+            sz = 1; break;
+        default:
+            return 0;
+    }
+    return sz <= (size_t)(end-p) ? sz : 0;
+}
+
+/**
+ * Checks the bytecode of an object once, before it is first ran:
+ *  - every instruction is known and has all of its operands,
+ *  - constants, simple variables and objects that are referred to exist,
+ *  - (the amount of inline caches is also counted)
+ *  - jumps land on the start of an instruction,
+ *  - the stack never goes below zero nor above the size of the header, whichever path is taken,
+ *    lists are closed in the order they are opened, and no list is open across a jump or a return.
+ * `run` relies on all of this and does not check it again
+ */
+static BasikException* verify(Code* code, const uint8_t* end) {
+    const uint8_t* orig = code->orig;
+    size_t n = end-orig;
+
+    // Instruction boundaries, and their operands
+    uint8_t* starts = new uint8_t[n+1]();
+    BasikException* err = nullptr;
+    size_t at = 0;
+    size_t cached = 0;
+    for (; at < n && err == nullptr; ) {
+        const uint8_t* p = orig+at;
+        size_t sz = instr_size(p,end);
+        if (sz == 0) { err = new BasikException(at+1,code,"Invalid instruction `%u`",*p); break; }
+        starts[at] = 1;
+        if (*p == OpCodes::LoadGlobal || *p == OpCodes::Call) cached++;
+        if ((*p == OpCodes::StoreSimple || *p == OpCodes::LoadSimple) && *(uint32_t*)(p+1) >= code->simple_vars_sz)
+            err = new BasikException(at+1,code,"Simple variable %u out of range",*(uint32_t*)(p+1));
+        else if (*p == OpCodes::ForRangeI64 && (*(uint32_t*)(p+1) >= code->simple_vars_sz || *(uint32_t*)(p+5) >= code->simple_vars_sz))
+            err = new BasikException(at+1,code,"Simple variable out of range");
+        else if (*p == OpCodes::PushString && *(uint32_t*)(p+1) >= code->const_data_sz)
+            err = new BasikException(at+1,code,"Constant %u out of range",*(uint32_t*)(p+1));
+        else if (*p == OpCodes::JumpIfNotCmp && p[1] > ArrayCmp::CmpGe)
+            err = new BasikException(at+1,code,"Invalid comparison `%u`",p[1]);
+        else if ((*p == OpCodes::LoadGlobal || *p == OpCodes::Call) && *(uint32_t*)(p+1) >= code->caches_sz)
+            code->caches_sz = *(uint32_t*)(p+1)+1; // There are as many inline caches as the highest index that is used
+        else if ((*p == OpCodes::LoadFunction || *p == OpCodes::Import) && code->objects->find((const char*)p+1) == nullptr)
+            err = new BasikException(at+1,code,"Unknown object `%s`",(const char*)p+1);
+        if (err == nullptr) at += sz;
+    }
+    // Each of them has its own cache, that no other instruction uses
+    if (err == nullptr && code->caches_sz > cached) err = new BasikException(at+1,code,"Inline cache %u out of range",code->caches_sz-1);
+    if (err == nullptr && code->caches_sz) {
+        uint8_t* used = new uint8_t[code->caches_sz]();
+        for (size_t i = 0; i < n && err == nullptr; i++) {
+            if (!starts[i] || (orig[i] != OpCodes::LoadGlobal && orig[i] != OpCodes::Call)) continue;
+            uint32_t c = *(uint32_t*)(orig+i+1);
+            if (used[c]++) {
+                at = i;
+                err = new BasikException(at+1,code,"Inline cache %u is shared",c);
+            }
+        }
+        delete[] used;
+    }
+
+    // Stack depths, following every path from the start
+    // (the depth of every instruction that was reached, and how many lists were open there)
+    int64_t* depths = new int64_t[n];
+    uint32_t* opens = new uint32_t[n];
+    for (size_t i = 0; i < n; i++) depths[i] = -1;
+    Stack<uint64_t> todo;  // (address << 32 | depth) of the paths left to follow
+    Stack<int64_t> bases; // Depths at which the open lists of the current path begin
+    int64_t top = 0;
+    if (err == nullptr) {
+        if (n == 0) err = new BasikException(at+1,code,"Empty object");
+        else todo.push(0);
+    }
+    while (err == nullptr && todo.size) {
+        uint64_t t = todo.pop();
+        at = t >> 32;
+        int64_t d = t & 0xffffffff;
+        bases.clear();
+        while (err == nullptr) {
+            if (at >= n) { at = n; err = new BasikException(at+1,code,"Execution goes past the end of the object"); break; }
+            if (depths[at] != -1) {
+                if (depths[at] != d || opens[at] != bases.size) err = new BasikException(at+1,code,"Inconsistent stack depth");
+                break;
+            }
+            depths[at] = d;
+            opens[at] = bases.size;
+            const uint8_t* p = orig+at;
+            uint8_t op = *p;
+            int64_t pop = 0, push = 0;
+            switch (op) {
+                case OpCodes::ListBegin: case OpCodes::DictBegin:
+                    bases.push(d);
+                    break;
+                case OpCodes::ListEnd: case OpCodes::DictEnd:
+                    if (bases.size == 0) { err = new BasikException(at+1,code,"Attempt to close a list that was not open"); break; }
+                    pop = d-bases.pop(); push = 1;
+                    break;
+                case OpCodes::ListExpand:
+                    pop = 1; push = *(uint32_t*)(p+1);
+                    break;
+                case OpCodes::StoreSimple: case OpCodes::StoreDynamic: case OpCodes::StoreGlobal: case OpCodes::Pop:
+                case OpCodes::JumpIf: case OpCodes::JumpIfNot: case OpCodes::Return:
+                    pop = 1; break;
+                case OpCodes::LoadSimple: case OpCodes::LoadDynamic: case OpCodes::LoadGlobal: case OpCodes::LoadFunction:
+                case OpCodes::PushString: case OpCodes::PushChar: case OpCodes::PushI16: case OpCodes::PushI32: case OpCodes::PushI64:
+                case OpCodes::PushBool: case OpCodes::PushNull: case OpCodes::PushArray:
+                    push = 1; break;
+                case OpCodes::Add: case OpCodes::Sub: case OpCodes::Div: case OpCodes::Mul: case OpCodes::Call: case OpCodes::Subscript:
+                case OpCodes::Equals: case OpCodes::NotEquals: case OpCodes::Less: case OpCodes::LessEquals: case OpCodes::Greater: case OpCodes::GreaterEquals:
+                    pop = 2; push = 1; break;
+                case OpCodes::Slice:
+                    pop = 3; push = 1; break;
+                case OpCodes::StoreSubscript:
+                    pop = 3; break;
+                case OpCodes::JumpIfNotCmp:
+                    pop = 2; break;
+                case OpCodes::Dup:
+                    pop = 1; push = 2; break;
+            }
+            if (err != nullptr) break;
+            if (d < pop || (bases.size && d-pop < bases.data[bases.size-1])) { err = new BasikException(at+1,code,"Stack underflow"); break; }
+            d += push-pop;
+            if (d > code->stack_sz) { err = new BasikException(at+1,code,"Stack overflow (%" PRId64 " values for a stack of %u)",d,code->stack_sz); break; }
+            if (d > top) top = d;
+            if (op == OpCodes::Return || op == OpCodes::End) {
+                if (bases.size) err = new BasikException(at+1,code,"Return with an open list");
+                break;
+            }
+            size_t sz = instr_size(p,end);
+            if (op == OpCodes::Jump || op == OpCodes::JumpIf || op == OpCodes::JumpIfNot || op == OpCodes::JumpIfNotCmp || op == OpCodes::ForRangeI64) {
+                uint64_t addr = *(uint64_t*)(p+sz-8);
+                if (addr >= n || !starts[addr]) { err = new BasikException(at+1,code,"Jump to %" PRIu64 ", which is not an instruction",addr); break; }
+                if (bases.size) { err = new BasikException(at+1,code,"Jump with an open list"); break; }
+                if (op == OpCodes::Jump) { at = addr; continue; }
+                todo.push(addr << 32 | d);
+            }
+            at += sz;
+        }
+    }
+
+    delete[] starts;
+    delete[] depths;
+    delete[] opens;
+    if (err == nullptr) {
+        // The size in the header is only a bound, the stack does not have to be any larger than what was found
+        code->stack_sz = top;
+        return nullptr;
+    }
+    return err;
+}
+
+Result pre_run(Code* code) {
+    if (code->initialized) return Result{nullptr,nullptr}; // Do not init again if it already was
+
+    const char*      &bytecode = code->bytecode;
+
+    basik_var**      &simple_vars  = code->simple_vars;
+    const_data_t**   &const_data   = code->const_data;
+
+    uint8_t* &ptr = code->ptr;
+    ptr = (uint8_t*)bytecode;
+    const uint8_t* end = (const uint8_t*)bytecode+code->bytecode_sz;
+
+    // Every part of the header has to fit in the object
+    #define HEADER_CHECK(cond,what) if (!(cond)) return Result{new BasikException(1,code,"Malformed object header (%s)",what),nullptr}
+
+    // Const Data Processing
+
+    HEADER_CHECK(end-ptr >= 4,"constants");
+    uint32_t const_data_sz = *(uint32_t*)ptr;
+    ptr += 4;
+    HEADER_CHECK(const_data_sz <= (end-ptr)/4,"constants");
+
+    const_data = new const_data_t*[const_data_sz];
+
+    for (uint32_t i = 0; i < const_data_sz; i++) {
+        HEADER_CHECK(end-ptr >= 4,"constants");
+        uint32_t sz = *(uint32_t*)ptr;
+        ptr += 4;
+        // Strings are the only kind of constant for now, and they are NUL terminated
+        HEADER_CHECK(sz > 0 && (size_t)(end-ptr) >= sz && ptr[sz-1] == 0,"constants");
+        const_data[i] = new const_data_t{sz,ptr,code->glob->strings.intern(sz,(const char*)ptr)};
+        code->const_data_sz = i+1;
+        ptr += sz;
+    }
+
+    // Variable Data Processing
+
+    HEADER_CHECK(end-ptr >= 4,"variables");
+    uint32_t simple_variable_data_sz = *(uint32_t*)ptr;
+    ptr += 4;
+    HEADER_CHECK(simple_variable_data_sz <= end-ptr,"variables");
+
+    simple_vars = new basik_var*[simple_variable_data_sz];
+
+    for (uint32_t i = 0; i < simple_variable_data_sz; i++) {
+        HEADER_CHECK(memchr(ptr,0,end-ptr) != nullptr,"variables");
+        size_t l = strlen((const char*)ptr);
+        simple_vars[i] = new basik_var{nullptr,(const char*)ptr};
+        code->simple_vars_sz = i+1;
+        ptr += l+1;
+    }
+
+    // Stack Processing
+
+    HEADER_CHECK(end-ptr >= 4,"stack");
+    code->stack_sz = *(uint32_t*)ptr;
+    ptr += 4;
+
+    // Line Table Processing (it is only decoded when needed)
+
+    HEADER_CHECK(end-ptr >= 4,"line table");
+    uint32_t line_table_sz = *(uint32_t*)ptr;
+    ptr += 4;
+
+    HEADER_CHECK((size_t)(end-ptr) >= line_table_sz,"line table");
+    HEADER_CHECK(line_table_sz == 0 || (memchr(ptr,0,line_table_sz) != nullptr && strlen((const char*)ptr)+5 <= line_table_sz),"line table");
+    code->lines = ptr;
+    code->lines_sz = line_table_sz;
+    ptr += line_table_sz;
+
+    #undef HEADER_CHECK
+
+    code->orig = ptr;
+    code->prog = ptr;
+
+    BasikException* e = verify(code,end);
+    if (e != nullptr) return Result{e,nullptr};
+
+    code->stack = new basik_val*[code->stack_sz];
+    code->caches = new inline_cache[code->caches_sz]();
+
+    code->initialized = true;
+    return Result{nullptr,nullptr};
+}
+
+Result run(Code* code) {
+    size_t      &stacki = code->stacki;
+
+    gc_t* &gc = code->gc;
+
+    const_data_t**   &const_data   = code->const_data;
+
+    uint8_t* &prog = code->prog;
+
+    basik_val* ret = nullptr;
+
+    // Every run starts at the beginning of the object
+    prog = code->orig;
+
+    // Running (the bytecode was checked by `verify` when the object was loaded)
+    // The instructions themselves are in `ops.h`
+
+    #define OP_CHECK(e) if (BasikException* except = (e)) return Result{except,nullptr}
+
+    while (*(uint8_t*)prog) {
+        uint8_t op = *(uint8_t*)prog;
+        prog += 1;
+
+        size_t instr = prog-code->orig;
+
+        instr_count++;
+
+        if (profiler != nullptr) profiler->step(code,instr-1);
+
+        // printf("----- %d %zu -----\n",op,stacki);
+
+        if (op == OpCodes::End) {
+            /* do nothing */
+            /* this should not even ever happen */
+        }
+
+        // Store
+
+        else if (op == OpCodes::StoreSimple) {
+            uint32_t var = *(uint32_t*)prog; prog += 4;
+            OP_CHECK(op_store_simple(code,instr,var));
+        }
+
+        else if (op == OpCodes::StoreDynamic) {
+            const char* varname = (const char*)prog; prog += strlen((const char*)prog)+1;
+            OP_CHECK(op_store_dynamic(code,instr,varname));
+        }
+
+        else if (op == OpCodes::StoreGlobal) {
+            const char* varname = (const char*)prog; prog += strlen((const char*)prog)+1;
+            OP_CHECK(op_store_global(code,instr,varname));
+        }
+
+        // Load
+
+        else if (op == OpCodes::LoadSimple) {
+            uint32_t var = *(uint32_t*)prog; prog += 4;
+            OP_CHECK(op_load_simple(code,instr,var));
+        }
+
+        else if (op == OpCodes::LoadDynamic) {
+            const char* varname = (const char*)prog; prog += strlen((const char*)prog)+1;
+            OP_CHECK(op_load_dynamic(code,instr,varname));
+        }
+
+        else if (op == OpCodes::LoadGlobal) {
+            uint32_t cache = *(uint32_t*)prog;
+            const char* varname = (const char*)prog+4; prog += 4+strlen(varname)+1;
+            OP_CHECK(op_load_global(code,instr,cache,varname));
+        }
+
+        // Remove
+
+        else if (op == OpCodes::RemoveDynamic) { // Cleans up a dynamic variable
+            const char* varname = (const char*)prog; prog += strlen((const char*)prog)+1;
+            code->dynvar_rem(varname);
+        }
+
+        // Integers
+
+        else if (op == OpCodes::PushChar) {
+            uint8_t data = *(uint8_t*)prog;
+            code->stack_push(val_char(data));
+            prog += 1;
+        }
+        else if (op == OpCodes::PushI16) {
+            int16_t data = *(int16_t*)prog;
+            code->stack_push(val_i16(data));
+            prog += 2;
+        }
+        else if (op == OpCodes::PushI32) {
+            int32_t data = *(int32_t*)prog;
+            code->stack_push(val_i32(data));
+            prog += 4;
+        }
+        else if (op == OpCodes::PushI64) {
+            int64_t data = *(int64_t*)prog;
+            code->stack_push(val_i64(data));
+            prog += 8;
+        }
+
+        else if (op == OpCodes::PushBool) {
+            code->stack_push(val_bool(*(uint8_t*)prog));
+            prog += 1;
+        }
+
+        // String
+
+        else if (op == OpCodes::PushString) {
+            int32_t val_addr = *(int32_t*)prog;
+            const_data_t* data = const_data[val_addr];
+            code->stack_push(data->val);
+            prog += 4;
+        }
+
+        // NULL
+
+        else if (op == OpCodes::PushNull) {
+            code->stack_push(nullptr);
+        }
+
+        // List
+
+        else if (op == OpCodes::ListBegin || op == OpCodes::DictBegin) {
+            code->list_stack.push(stacki);
+        }
+        else if (op == OpCodes::ListEnd) {
+            op_list_end(code);
+        }
+        else if (op == OpCodes::DictEnd) {
+            OP_CHECK(op_dict_end(code,instr));
+        }
+        else if (op == OpCodes::Subscript) {
+            OP_CHECK(op_subscript(code,instr));
+        }
+        else if (op == OpCodes::StoreSubscript) {
+            OP_CHECK(op_store_subscript(code,instr));
+        }
+        else if (op == OpCodes::PushArray) {
+            DataType type = (DataType)*prog;
+            uint32_t size = *(uint32_t*)(prog+1);
+            OP_CHECK(op_push_array(code,instr,type,size,prog+5));
+            prog += 5+size*BasikArray::elem_size(type);
+        }
+        else if (op == OpCodes::Slice) {
+            OP_CHECK(op_slice(code,instr));
+        }
+        else if (op == OpCodes::ListExpand) {
+            uint32_t n = *(uint32_t*)prog; prog += 4;
+            OP_CHECK(op_list_expand(code,instr,n));
+        }
+
+        // Arithmetic
+
+        else if (op == OpCodes::Add) {
+            OP_CHECK(op_arith<'+'>(code,instr));
+        }
+        else if (op == OpCodes::Sub) {
+            OP_CHECK(op_arith<'-'>(code,instr));
+        }
+        else if (op == OpCodes::Mul) {
+            OP_CHECK(op_arith<'*'>(code,instr));
+        }
+        else if (op == OpCodes::Div) {
+            OP_CHECK(op_arith<'/'>(code,instr));
+        }
+
+        else if (op == OpCodes::Equals || (op >= OpCodes::NotEquals && op <= OpCodes::GreaterEquals)) {
+            static const ArrayCmp cmps[] = { CmpNe, CmpLt, CmpLe, CmpGt, CmpGe };
+            OP_CHECK(op_compare_push(code,instr,op == OpCodes::Equals ? CmpEq : cmps[op-OpCodes::NotEquals]));
+        }
+
+        // Stack
+
+        else if (op == OpCodes::Pop) {
+            code->stack_pop();
+        }
+
+        else if (op == OpCodes::Dup) {
+            basik_val* v = code->stack_pop();
+            code->stack_push(v);
+            code->stack_push(v);
+        }
+
+        // Jumping
+
+        else if (op == OpCodes::Jump) {
+            uint64_t addr = *(uint64_t*)prog;
+            prog += 8;
+            prog = code->orig + addr;
+        }
+
+        else if (op == OpCodes::JumpIf) {
+            uint64_t addr = *(uint64_t*)prog; prog += 8;
+            basik_val* v = code->stack_pop();
+            if (code->is_val_true(v)) {
+                prog = code->orig + addr;
+            }
+        }
+
+        else if (op == OpCodes::JumpIfNot) {
+            uint64_t addr = *(uint64_t*)prog; prog += 8;
+            basik_val* v = code->stack_pop();
+            if (!code->is_val_true(v)) {
+                prog = code->orig + addr;
+            }
+        }
+
+        else if (op == OpCodes::JumpIfNotCmp) { // A comparison followed by a JumpIfNot, without the boolean in between
+            ArrayCmp cmp = (ArrayCmp)*prog;
+            uint64_t addr = *(uint64_t*)(prog+1); prog += 9;
+            bool t = false;
+            OP_CHECK(op_compare(code,instr,cmp,&t));
+            if (!t) prog = code->orig + addr;
+        }
+
+        else if (op == OpCodes::ForRangeI64) { // Steps the counter of a `for _ in range(...)` loop and jumps back to its body if it did not reach the end
+            uint32_t var  = *(uint32_t*)prog;
+            uint32_t stop = *(uint32_t*)(prog+4);
+            int64_t  step = *(int64_t*)(prog+8);
+            uint64_t addr = *(uint64_t*)(prog+16);
+            prog += 24;
+            bool loop = false;
+            OP_CHECK(op_for_range(code,instr,var,stop,step,&loop));
+            if (loop) prog = code->orig + addr;
+        }
+
+        // Functions
+
+        else if (op == OpCodes::Return) {
+            ret = op_return(code);
+            break;
+        }
+
+        else if (op == OpCodes::Call) {
+            uint32_t cache = *(uint32_t*)prog; prog += 4;
+            OP_CHECK(op_call(code,instr,cache));
+        }
+
+        else if (op == OpCodes::LoadFunction) {
+            const char* id = (const char*)prog; prog += strlen((const char*)prog)+1;
+            op_load_function(code,id);
+        }
+
+        else if (op == OpCodes::Import) { // Runs the top-level code of a module the first time it is imported
+            const char* id = (const char*)prog; prog += strlen((const char*)prog)+1;
+            OP_CHECK(op_import(code,instr,id));
+        }
+
+        // Unknown opcodes are rejected by `verify`
+
+        gc->collect();
+    
+    }
+
+    #undef OP_CHECK
+
+    return op_leave(code,ret);
+
+}
+
+bool ends_with(const char* str, const char* end) {
+    size_t strl = strlen(str);
+    size_t endl = strlen(end);
+    if (strl < endl) return false;
+    for (size_t i = 0; i < endl; i++)
+        if (str[strl-i-1] != end[endl-i-1]) 
+            return false;
+    return true;
+}
+
+bool has( Stack<const char*>& s, const char* v ) {
+    for (size_t i = 0; i < s.size; i++) {
+        if (!strcmp(s.data[i],v)) return true;
+    }
+    return false;
+}
+
+void print_repr(Output* out, basik_val* v) {
+         if (v->type == DataType::Char)   { out->put('\''); out->write_i64(*((BasikChar*)v->data)->data); out->put('\''); } // Should escape it
+    else if (v->type == DataType::I16)    { out->write_i64(*((BasikI16*)v->data)->data); out->write_str("i16"); }
+    else if (v->type == DataType::I32)    { out->write_i64(*((BasikI32*)v->data)->data); out->write_str("i32"); }
+    else if (v->type == DataType::I64)    { out->write_i64(*((BasikI64*)v->data)->data); out->write_str("i64"); }
+    else if (v->type == DataType::String) { out->put('"'); out->write(((BasikString*)v->data)->data,((BasikString*)v->data)->len-1); out->put('"'); } // Should also escape it
+}
+
+Result basik_std_print(Code* code, size_t argc, basik_val** argv) {
+    Output* out = code->glob->output;
+    for (size_t i = 0; i < argc; i++) {
+        basik_val* arg = argv[i];
+        if (arg == nullptr) out->write_str("None");
+        else {
+                 if (arg->type == DataType::Char)   out->put(*((BasikChar*)arg->data)->data);
+            else if (arg->type == DataType::I16)    out->write_i64(*((BasikI16*)arg->data)->data);
+            else if (arg->type == DataType::I32)    out->write_i64(*((BasikI32*)arg->data)->data);
+            else if (arg->type == DataType::I64)    out->write_i64(*((BasikI64*)arg->data)->data);
+            else if (arg->type == DataType::String) out->write(((BasikString*)arg->data)->data,((BasikString*)arg->data)->len-1);
+            else if (arg->type == DataType::Bool)   out->write_str(*((BasikBool*)arg->data)->data ? "True" : "False");
+            else {
+                char obj[32];
+                snprintf(obj,sizeof(obj),"<object at %p>",(void*)arg);
+                out->write_str(obj);
+            }
+        }
+        if (i < argc-1) out->put(' ');
+    }
+    out->newline();
+    return Result{nullptr,nullptr};
+}
+
+Result basik_std_input(Code* code, size_t argc, basik_val** argv) {
+    // Whatever was printed before (like a prompt) has to be visible
+    code->glob->output->flush();
+    BasikString* line = code->glob->input->readline();
+    if (line == nullptr) return Result{nullptr,nullptr};
+    // The line break is not part of the value
+    if (line->len > 1 && line->data[line->len-2] == '\n') line->len--;
+    return Result{nullptr,new basik_val{DataType::String,line}};
+}
+
+BASIK_COLD Result builtin_error(Code* code, const char* fmt, ...) {
+    BasikException* e = new BasikException("",0,nullptr);
+    va_list args;
+    va_start(args,fmt);
+    e->set_text(fmt,args);
+    va_end(args);
+    return Result{e,nullptr};
+}
+
+const char* type_name(basik_val* v) {
+    return v == nullptr ? "NULL" : get_data_type_str(v->type);
+}
+
+bool int_value(basik_val* v, int64_t* out) {
+    if (v == nullptr) return false;
+         if (v->type == DataType::Char) *out = *((BasikChar*)v->data)->data;
+    else if (v->type == DataType::I16)  *out = *((BasikI16*)v->data)->data;
+    else if (v->type == DataType::I32)  *out = *((BasikI32*)v->data)->data;
+    else if (v->type == DataType::I64)  *out = *((BasikI64*)v->data)->data;
+    else if (v->type == DataType::Bool) *out = *((BasikBool*)v->data)->data;
+    else return false;
+    return true;
+}
+
+/**
+ * Opens the file at the path held by a `String` value, gives back `nullptr` if it could not be opened
+ */
+static FILE* open_path(basik_val* v, const char* mode) {
+    BasikString* s = (BasikString*)v->data;
+    char* path = new char[s->len];
+    memcpy(path,s->data,s->len-1);
+    path[s->len-1] = 0;
+    FILE* f = fopen(path,mode);
+    delete[] path;
+    return f;
+}
+
+/**
+ * Retreives the reader of an optional `File` argument, the standard input when there is none
+ */
+static Input* arg_input(Code* code, size_t argc, basik_val** argv) {
+    if (argc == 0) {
+        // Whatever was printed before (like a prompt) has to be visible
+        code->glob->output->flush();
+        return code->glob->input;
+    }
+    return ((BasikFile*)argv[0]->data)->in;
+}
+
+Result basik_std_readline(Code* code, size_t argc, basik_val** argv) {
+    if (argc > 1) return builtin_error(code,"readline() takes at most 1 argument (%zu given)",argc);
+    if (argc == 1 && (argv[0] == nullptr || argv[0]->type != DataType::File)) return builtin_error(code,"readline() expects a File, got `%s`",type_name(argv[0]));
+    BasikString* line = arg_input(code,argc,argv)->readline();
+    // Like python, an empty string means that the end of the input was reached
+    if (line == nullptr) return Result{nullptr,new basik_val{DataType::String,new BasikString(1,"")}};
+    return Result{nullptr,new basik_val{DataType::String,line}};
+}
+
+Result basik_std_lines(Code* code, size_t argc, basik_val** argv) {
+    if (argc > 1) return builtin_error(code,"lines() takes at most 1 argument (%zu given)",argc);
+    Input* in = nullptr;
+    FILE* f = nullptr;
+    if (argc == 1 && argv[0] != nullptr && argv[0]->type == DataType::String) {
+        f = open_path(argv[0],"rb");
+        if (f == nullptr) return builtin_error(code,"lines(): could not open `%.*s`",(int)((BasikString*)argv[0]->data)->len-1,((BasikString*)argv[0]->data)->data);
+        in = new Input(f,65536);
+    } else if (argc == 1 && (argv[0] == nullptr || argv[0]->type != DataType::File))
+        return builtin_error(code,"lines() expects a String path or a File, got `%s`",type_name(argv[0]));
+    else
+        in = arg_input(code,argc,argv);
+    BasikList* list = new BasikList();
+    for (BasikString* line; (line = in->readline()) != nullptr;) {
+        basik_val* v = new basik_val{DataType::String,line};
+        code->gc->add_ref(v);
+        list->append(v);
+    }
+    if (f != nullptr) {
+        fclose(f);
+        delete in;
+    }
+    return Result{nullptr,new basik_val{DataType::List,list}};
+}
+
+Result basik_std_open(Code* code, size_t argc, basik_val** argv) {
+    if (argc != 1) return builtin_error(code,"open() takes 1 argument (%zu given)",argc);
+    if (argv[0] == nullptr || argv[0]->type != DataType::String) return builtin_error(code,"open() expects a String path, got `%s`",type_name(argv[0]));
+    FILE* f = open_path(argv[0],"rb");
+    if (f == nullptr) return builtin_error(code,"open(): could not open `%.*s`",(int)((BasikString*)argv[0]->data)->len-1,((BasikString*)argv[0]->data)->data);
+    return Result{nullptr,new basik_val{DataType::File,new BasikFile(f)}};
+}
+
+Result basik_std_read(Code* code, size_t argc, basik_val** argv) {
+    if (argc > 1) return builtin_error(code,"read() takes at most 1 argument (%zu given)",argc);
+    if (argc == 1 && argv[0] != nullptr && argv[0]->type == DataType::String) {
+        FILE* f = open_path(argv[0],"rb");
+        if (f == nullptr) return builtin_error(code,"read(): could not open `%.*s`",(int)((BasikString*)argv[0]->data)->len-1,((BasikString*)argv[0]->data)->data);
+        // The whole file fits in the first block, along with a spare byte for the read that finds the end of the file,
+        // so it is read without growing it (unless its size is unknown, like for pipes)
+#if defined(__linux__)
+        struct stat st;
+        off64_t sz = fstat(fileno(f),&st) == 0 ? st.st_size : 0;
+#else
+        fseeko64(f,0,SEEK_END);
+        off64_t sz = ftello64(f);
+        fseeko64(f,0,SEEK_SET);
+#endif
+        Input in(f,sz > 0 ? sz+1 : 65536);
+        BasikString* s = in.read_all();
+        fclose(f);
+        return Result{nullptr,new basik_val{DataType::String,s}};
+    }
+    if (argc == 1 && (argv[0] == nullptr || argv[0]->type != DataType::File)) return builtin_error(code,"read() expects a String path or a File, got `%s`",type_name(argv[0]));
+    return Result{nullptr,new basik_val{DataType::String,arg_input(code,argc,argv)->read_all()}};
+}
+
+Result basik_std_mmap_file(Code* code, size_t argc, basik_val** argv) {
+    if (argc != 1) return builtin_error(code,"mmap_file() takes 1 argument (%zu given)",argc);
+    if (argv[0] == nullptr || argv[0]->type != DataType::String) return builtin_error(code,"mmap_file() expects a String path, got `%s`",type_name(argv[0]));
+#if defined(__linux__)
+    BasikString* ps = (BasikString*)argv[0]->data;
+    char* path = new char[ps->len];
+    memcpy(path,ps->data,ps->len-1);
+    path[ps->len-1] = 0;
+    int fd = ::open(path,O_RDONLY);
+    delete[] path;
+    if (fd < 0) return builtin_error(code,"mmap_file(): could not open `%.*s`",(int)ps->len-1,ps->data);
+    struct stat st;
+    if (fstat(fd,&st) < 0 || st.st_size == 0) {
+        close(fd);
+        return Result{nullptr,new basik_val{DataType::String,new BasikString(1,"")}};
+    }
+    void* mem = mmap(nullptr,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if (mem == MAP_FAILED) return builtin_error(code,"mmap_file(): could not map `%.*s`",(int)ps->len-1,ps->data);
+    // The contents are usually scanned from start to end
+    madvise(mem,st.st_size,MADV_SEQUENTIAL);
+    BasikStringBuf* buf = BasikStringBuf::map(mem,st.st_size);
+    BasikString* s = BasikString::view(buf,0,st.st_size);
+    BasikStringBuf::release(buf);
+    return Result{nullptr,new basik_val{DataType::String,s}};
+#else
+    // Files are simply read where mmap is not available
+    return basik_std_read(code,argc,argv);
+#endif
+}
+
+static inline bool is_space(uint8_t c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+Result basik_std_split(Code* code, size_t argc, basik_val** argv) {
+    if (argc < 1 || argc > 2) return builtin_error(code,"split() takes 1 or 2 arguments (%zu given)",argc);
+    if (argv[0] == nullptr || argv[0]->type != DataType::String) return builtin_error(code,"split() expects a String, got `%s`",type_name(argv[0]));
+    basik_val* sep = argc > 1 ? argv[1] : nullptr;
+    if (sep != nullptr && sep->type != DataType::String) return builtin_error(code,"split() expects a String separator, got `%s`",type_name(sep));
+    BasikString* s = (BasikString*)argv[0]->data;
+    BasikList* list = new BasikList();
+    auto add = [&](size_t off, size_t sz) {
+        basik_val* v = new basik_val{DataType::String,s->slice(off,sz)};
+        code->gc->add_ref(v);
+        list->append(v);
+    };
+    size_t n = s->len-1;
+    if (sep == nullptr) {
+        // Like python, runs of whitespace separate the parts and there are no empty ones
+        size_t i = 0;
+        while (i < n) {
+            while (i < n && is_space(s->data[i])) i++;
+            if (i == n) break;
+            size_t j = i;
+            while (j < n && !is_space(s->data[j])) j++;
+            add(i,j-i);
+            i = j;
+        }
+    } else {
+        BasikString* ss = (BasikString*)sep->data;
+        if (ss->len == 1) {
+            delete list;
+            return builtin_error(code,"split(): empty separator");
+        }
+        size_t i = 0;
+        for (int64_t j; (j = s->find(ss,i)) >= 0; i = j+ss->len-1) add(i,j-i);
+        add(i,n-i);
+    }
+    return Result{nullptr,new basik_val{DataType::List,list}};
+}
+
+Result basik_std_find(Code* code, size_t argc, basik_val** argv) {
+    if (argc < 2 || argc > 3) return builtin_error(code,"find() takes 2 or 3 arguments (%zu given)",argc);
+    if (argv[0] == nullptr || argv[0]->type != DataType::String) return builtin_error(code,"find() expects a String, got `%s`",type_name(argv[0]));
+    if (argv[1] == nullptr || argv[1]->type != DataType::String) return builtin_error(code,"find() expects a String to find, got `%s`",type_name(argv[1]));
+    int64_t from = 0;
+    if (argc > 2) {
+        if (argv[2] == nullptr || argv[2]->type != DataType::I64) return builtin_error(code,"find() expects an I64 start, got `%s`",type_name(argv[2]));
+        from = *((BasikI64*)argv[2]->data)->data;
+        if (from < 0) from = 0;
+    }
+    int64_t r = ((BasikString*)argv[0]->data)->find((BasikString*)argv[1]->data,from);
+    return Result{nullptr,val_i64(r)};
+}
+
+Result basik_std_join(Code* code, size_t argc, basik_val** argv) {
+    if (argc < 1 || argc > 2) return builtin_error(code,"join() takes 1 or 2 arguments (%zu given)",argc);
+    basik_val* l = argv[0];
+    basik_val* sep = argc > 1 ? argv[1] : nullptr;
+    if (l == nullptr || l->type != DataType::List) return builtin_error(code,"join() expects a List, got `%s`",type_name(l));
+    if (sep != nullptr && sep->type != DataType::String) return builtin_error(code,"join() expects a String separator, got `%s`",type_name(sep));
+    BasikList* list = (BasikList*)l->data;
+    size_t sep_len = sep != nullptr ? ((BasikString*)sep->data)->len-1 : 0;
+    // Computes the size first so that the result is allocated only once
+    size_t len = 1;
+    for (size_t i = 0; i < list->size; i++) {
+        basik_val* v = (*list)[i];
+        if (v == nullptr || v->type != DataType::String) return builtin_error(code,"join() expects a List of String, got `%s` at %zu",type_name(v),i);
+        len += ((BasikString*)v->data)->len-1;
+        if (i) len += sep_len;
+    }
+    uint8_t* d = new uint8_t[len];
+    uint8_t* p = d;
+    for (size_t i = 0; i < list->size; i++) {
+        BasikString* s = (BasikString*)(*list)[i]->data;
+        if (i && sep_len) {
+            memcpy(p,((BasikString*)sep->data)->data,sep_len);
+            p += sep_len;
+        }
+        memcpy(p,s->data,s->len-1);
+        p += s->len-1;
+    }
+    *p = 0;
+    return Result{nullptr,new basik_val{DataType::String,BasikString::take(len,d)}};
+}
+
+Result basik_std_flush(Code* code, size_t argc, basik_val** argv) {
+    code->glob->output->flush();
+    return Result{nullptr,nullptr};
+}
@@ -4,13 +4,29 @@
 #include <stdio.h>
 #include <string.h>
 #include <cinttypes>
+#include <type_traits>
+#include <stdarg.h>
 
 /**
- * Formats a string
- * NOTE: Not that great, might have to implement this in a better way at some point
- */ 
-template<typename ... A>
-const char* format(const char* format, A ...args);
+ * USDT static probes (`basik:*`), they are only available when `sys/sdt.h` is (systemtap-sdt-dev)
+ * and cost a single nop when nothing is attached to them
+ */
+#if defined(__has_include)
+    #if __has_include(<sys/sdt.h>)
+        #include <sys/sdt.h>
+        #define BASIK_HAS_USDT
+    #endif
+#endif
+
+#ifdef BASIK_HAS_USDT
+    #define BASIK_PROBE1(name,a)     DTRACE_PROBE1(basik,name,a)
+    #define BASIK_PROBE2(name,a,b)   DTRACE_PROBE2(basik,name,a,b)
+    #define BASIK_PROBE3(name,a,b,c) DTRACE_PROBE3(basik,name,a,b,c)
+#else
+    #define BASIK_PROBE1(name,a)     ((void)0)
+    #define BASIK_PROBE2(name,a,b)   ((void)0)
+    #define BASIK_PROBE3(name,a,b,c) ((void)0)
+#endif
 
 using namespace std;
 
@@ -28,7 +44,11 @@ struct BasikI32;
 struct BasikI64;
 struct BasikString;
 struct BasikList;
+struct BasikListBuf;
 struct BasikFunction;
+struct BasikFile;
+struct BasikDict;
+struct BasikArray;
 
 struct BasikException;
 struct Result;
@@ -38,6 +58,9 @@ struct Buffer;
 
 struct gc_t;
 
+struct Input;
+struct Output;
+
 // Simple Data //
 
 enum OpCodes : uint8_t {
@@ -70,7 +93,22 @@ enum OpCodes : uint8_t {
     Call,
     PushNull,
     Equals,
-    LoadFunction
+    LoadFunction,
+    DictBegin,
+    DictEnd,
+    Subscript,
+    StoreSubscript,
+    PushArray,
+    Slice,
+    PushBool,
+    NotEquals,
+    Less,
+    LessEquals,
+    Greater,
+    GreaterEquals,
+    JumpIfNotCmp,
+    ForRangeI64,
+    Import
 };
 
 enum DataType : uint16_t {
@@ -81,7 +119,10 @@ enum DataType : uint16_t {
     I64,
     List,
     Function,
-    Bool
+    Bool,
+    File,
+    Dict,
+    Array
 };
 
 enum FunctionKind : uint8_t {
@@ -89,7 +130,7 @@ enum FunctionKind : uint8_t {
     CodeFunction
 };
 
-const char* DataTypeStr[] = {
+inline const char* DataTypeStr[] = {
     "String",
     "Char",
     "I16",
@@ -97,16 +138,27 @@ const char* DataTypeStr[] = {
     "I64",
     "List",
     "Function",
-    "Bool"
+    "Bool",
+    "File",
+    "Dict",
+    "Array"
 };
 
-constexpr inline const char* get_data_type_str(DataType dt);
+/**
+ * Retreives the string representation of a data type value
+ */
+constexpr inline const char* get_data_type_str(DataType dt) {
+    if (dt >= sizeof(DataTypeStr)/sizeof(const char*)) return "<INVALID TYPE>";
+    return DataTypeStr[dt];
+}
 
 // Basic Structures //
 
 struct const_data_t {
     uint64_t sz;
     void* data;
+    // The value of the constant, shared by every instruction that pushes it
+    basik_val* val;
 };
 
 struct basik_val {
@@ -150,23 +202,135 @@ struct BasikI64 {
     ~BasikI64();
 };
 
-struct BasikString {
+/**
+ * A refcounted buffer that strings can point into without owning their own copy of the data
+ * Strings built by concatenation are prefixes of one, so that `s = s + x` appends in place
+ * instead of copying `s` (amortized by doubling the capacity), input readers use them as blocks
+ * that the lines they read are views into, and mapped files are one
+ */
+struct BasikStringBuf {
+    size_t refs;
+    size_t cap;
+    // The amount of bytes in use, the strings using the buffer only see their own part of it
+    size_t used;
+    // Whether concatenations may write after `used`, false when something else fills the buffer
+    bool appendable;
+    // Whether `data` is a memory mapping (see `map`) instead of being allocated with the buffer
+    bool mapped;
     uint8_t* data;
+
+    /**
+     * Allocates a buffer with a single reference
+     */
+    static BasikStringBuf* create(size_t cap, bool appendable);
+
+    /**
+     * Creates a buffer with a single reference around `sz` bytes mapped with `mmap`, they are unmapped when it is released
+     */
+    static BasikStringBuf* map(void* mem, size_t sz);
+
+    /**
+     * Removes a reference to the buffer, freeing it when it was the last one
+     */
+    static void release(BasikStringBuf* buf);
+};
+
+/**
+ * An immutable string, `len` includes the null terminator
+ * NOTE: Strings sharing a buffer are not null-terminated, `len` has to be used to read them
+ * Interned strings borrow their data (usually from the constant pool) and are never destroyed,
+ * so two interned strings are equal if and only if they are the same object
+ */
+struct BasikString {
+    const uint8_t* data;
     size_t len;
+    uint64_t hash;
+    bool interned;
+    // Whether `data` was allocated with `new[]` for this string alone
+    bool owned;
+    BasikStringBuf* buf;
 
     BasikString(size_t len, const char* data);
+    BasikString(size_t len, const char* data, uint64_t hash);
     ~BasikString();
+
+    /**
+     * Creates a string that views `sz` bytes of `buf` starting at `off`, holding a reference to the buffer
+     */
+    static BasikString* view(BasikStringBuf* buf, size_t off, size_t sz);
+
+    /**
+     * Creates a string that views `sz` bytes of this one starting at `off`, without copying them
+     * NOTE: A string that owns its data gets it moved into a buffer the first time it is sliced
+     */
+    BasikString* slice(size_t off, size_t sz);
+
+    /**
+     * Finds the first occurence of `sub` at or after `from`, returns `-1` if there is none
+     */
+    int64_t find(BasikString* sub, size_t from);
+
+    /**
+     * Creates a string that owns `data`, which has to be null-terminated and allocated with `new[]`
+     */
+    static BasikString* take(size_t len, uint8_t* data);
+
+    /**
+     * Concatenates two `String` values, appending to the buffer of `a` when it is the last string that was built in it
+     */
+    static basik_val* concat(basik_val* a, basik_val* b);
+
+    static uint64_t hash_of(size_t len, const char* data);
+
+    /**
+     * Compares the contents of two strings, only comparing the pointers when both are interned
+     */
+    static bool equals(BasikString* a, BasikString* b);
 };
 
+/**
+ * A list, which views `size` elements of its buffer starting at `off`
+ * Slicing a list gives back a list sharing the same buffer, the buffer is only copied
+ * once a list that shares it is modified (see `own`)
+ */
 struct BasikList {
-    Stack<basik_val>* data;
+    BasikListBuf* buf;
+    size_t off;
+    size_t size;
 
     BasikList();
+
+    /**
+     * Creates a list viewing `size` elements of `from` starting at `off`, without copying them
+     */
+    BasikList(BasikList* from, size_t off, size_t size);
+
     ~BasikList();
 
+    /**
+     * Gives the list a buffer of its own if it shares it or only views a part of it,
+     * copying its elements and adding a reference to them in `gc`
+     * Has to be called before modifying the elements of the list
+     */
+    void own(gc_t* gc);
+
+    /**
+     * Adds a value at the end of the list
+     * NOTE: Only meant to build new lists, `own` has to be called first if the list could be shared
+     */
     void append(basik_val* v);
 
-    constexpr inline basik_val* operator[](size_t i);
+    void reserve(size_t cap);
+
+    /**
+     * Replaces an element of the list, moving the reference that the list holds from the old value to the new one
+     */
+    void set(gc_t* gc, size_t i, basik_val* v);
+
+    // The elements of the list, valid until the list is modified
+    inline basik_val** items();
+
+    inline basik_val* operator[](size_t i);
 };
 
 struct BasikFunction {
@@ -178,6 +342,97 @@ struct BasikFunction {
     ~BasikFunction();
 };
 
+/**
+ * A hash map, an open-addressed table with linear probing whose slots store the hash of their key
+ * next to it, so that probing only has to look at the keys whose hash matches
+ * It holds a reference to all of its keys and values
+ */
+struct BasikDict {
+
+    struct slot {
+        uint64_t hash;
+        // `nullptr` for an empty slot
+        basik_val* key;
+        basik_val* value;
+    };
+
+    gc_t* gc;
+    slot* slots;
+    size_t cap;
+    size_t size;
+
+    BasikDict(gc_t* gc, size_t size);
+    ~BasikDict();
+
+    /**
+     * Whether a value can be used as a key
+     */
+    static bool hashable(basik_val* key);
+
+    /**
+     * Hashes a key, the hash of strings is computed only once
+     */
+    static uint64_t hash_of(basik_val* key);
+
+    static bool key_equals(basik_val* a, basik_val* b);
+
+    /**
+     * Finds the slot of a key, gives back `nullptr` if the key is not in the dict
+     */
+    slot* find(basik_val* key);
+
+    void set(basik_val* key, basik_val* value);
+
+private:
+    slot* probe(basik_val* key, uint64_t hash);
+    void grow();
+
+};
+
+struct BasikFile {
+    Input* in;
+
+    BasikFile(FILE* file);
+    ~BasikFile();
+};
+
+/**
+ * A typed array of integers, stored unboxed in a single contiguous buffer so that bulk operations
+ * run over it with vectorized kernels instead of dispatching on every element (see `array.cpp`)
+ */
+struct BasikArray {
+    // The type of the elements, I16, I32 or I64
+    DataType type;
+    size_t size;
+    void* data;
+
+    /**
+     * Creates an array of `size` zeroes, `data` is `nullptr` if it could not be allocated
+     */
+    BasikArray(DataType type, size_t size);
+    ~BasikArray();
+
+    /**
+     * Creates an array of `size` zeroes, gives back `nullptr` if it is too large to be allocated
+     */
+    static BasikArray* create(DataType type, size_t size);
+
+    static size_t elem_size(DataType type);
+
+    /**
+     * Whether `v` can be stored in an element of `type` without being truncated
+     */
+    static bool fits(DataType type, int64_t v);
+
+    int64_t get(size_t i);
+    void set(size_t i, int64_t v);
+
+    /**
+     * Boxes an element into a value of the type of the array
+     */
+    basik_val* box(size_t i);
+};
+
 struct BasikBool {
     bool* data;
 
@@ -185,37 +440,141 @@ struct BasikBool {
     ~BasikBool();
 };
 
+/**
+ * Error paths are moved out of the way of the code that raises them
+ */
+#define BASIK_COLD __attribute__((cold,noinline))
+
+/**
+ * An error that happened while running, along with the instructions it went through
+ * Raising one does not allocate: its text and the first frames of its trace are stored inline,
+ * and the objects themselves are recycled once deleted (see `operator new`)
+ */
 struct BasikException {
-    // The text of the error
+    struct frame {
+        size_t addr;
+        Code*  code;
+    };
+    static const size_t INLINE_FRAMES = 8;
+
+    // The text of the error, either a literal or `buf`
     const char* text;
-    // The addresses where the error has occured
-    size_t* trace;
-    // The code objects where the error has occured
-    Code**  code_trace;
+    // The places where the error has occured, `inline_frames` until the trace outgrows it
+    frame*  frames;
     // The trace size
     size_t  traci;
+    size_t  tracecap;
+    frame   inline_frames[INLINE_FRAMES];
+    char    buf[256];
 
-    BasikException(const char* text, size_t origin, Code* origin_code) {
-        this->text = text;
-        this->trace = new size_t[65536];
-        this->code_trace = new Code*[65536];
-        this->trace[0] = origin;
-        this->code_trace[0] = origin_code;
-        this->traci = 1;
-    }
-    ~BasikException() {
-        delete[] this->trace;
-    }
+    BasikException(const char* text, size_t origin, Code* origin_code);
+    // Formats the text into the exception itself, texts without any `%` are used as they are
+    BasikException(size_t origin, Code* origin_code, const char* fmt, ...) __attribute__((format(printf,4,5)));
+    ~BasikException();
 
     BasikException* add_trace(size_t addr, Code* code) {
-        this->code_trace[this->traci] = code;
-        this->trace[this->traci++]    = addr;
+        if (this->traci == this->tracecap) this->grow();
+        this->frames[this->traci++] = frame{addr,code};
         return this;
     }
+
+    void grow();
+    void set_text(const char* fmt, va_list args);
+
+    static void* operator new(size_t sz);
+    static void operator delete(void* p);
 };
 
 // Data Structures // 
 
+/**
+ * A structure to store data with an access towards the top, values are stored inline
+ * and the capacity doubles whenever it is exceeded, so pushing is amortized O(1)
+ * NOTE: Values are moved around with memcpy/realloc, so they have to be trivially copyable
+ */
+template<typename T>
+struct Stack {
+    static_assert(is_trivially_copyable<T>::value,"Stack values have to be trivially copyable");
+
+    T* data;
+    size_t cap;
+    size_t size;
+    Stack() {
+        this->cap = 0;
+        this->data = nullptr;
+        this->size = 0;
+    }
+    Stack(size_t cap) {
+        this->cap = 0;
+        this->data = nullptr;
+        this->size = 0;
+        this->reserve(cap);
+    }
+    Stack(const Stack&) = delete;
+    Stack& operator=(const Stack&) = delete;
+    /**
+     * Makes sure that `cap` values can be stored without having to reallocate
+     */
+    void reserve(size_t cap) {
+        if (this->cap >= cap) return;
+        this->data = (T*)realloc((void*)this->data,sizeof(T)*cap);
+        this->cap = cap;
+    }
+    void push(T value) {
+        if (this->size == this->cap) this->reserve(this->cap ? this->cap*2 : 8);
+        this->data[this->size++] = value;
+    }
+    /**
+     * Removes all the values for which `hole(value)` is true, keeping the order of the others
+     */
+    template<typename F>
+    void prune(F hole) {
+        size_t sz = 0;
+        for (size_t i = 0; i < this->size; i++) if (!hole(this->data[i])) this->data[sz++] = this->data[i];
+        this->size = sz;
+    }
+    /**
+     * Removes all the null values
+     */
+    void prune() {
+        this->prune([](const T& v) { return v == T{}; });
+    }
+    /**
+     * Removes the top value, gives back a null value if the stack is empty
+     */
+    T pop() {
+        if (this->size == 0) return T{};
+        return this->data[--this->size];
+    }
+    void clear() {
+        this->size = 0;
+    }
+    ~Stack() {
+        free((void*)this->data);
+    }
+};
+
+/**
+ * The storage of lists, shared by a list and its slices until one of them is modified
+ * It holds a reference to each of its elements
+ */
+struct BasikListBuf {
+    size_t refs;
+    Stack<basik_val*> items;
+
+    BasikListBuf() {
+        this->refs = 1;
+    }
+};
+
+inline basik_val** BasikList::items() {
+    return this->buf->items.data+this->off;
+}
+
+inline basik_val* BasikList::operator[](size_t i) {
+    return this->buf->items.data[this->off+i];
+}
+
 struct Result {
     BasikException* except;
     basik_val* value;
@@ -246,19 +605,31 @@ struct gc_t {
     };
 
     Stack<gc_ref>* refs;
+    // Where the entry of every value is in `refs` (plus one, 0 is an empty slot), an open-addressed table keyed by address
+    size_t* index;
+    size_t index_cap;
+    // The values whose count went down to 0 since the last collection, the only ones `collect` has to look at
+    Stack<basik_val*> dead;
+
+    // The amount of values that have been registered since the creation of the GC
+    size_t allocs;
 
     gc_t();
+    /**
+     * Frees every value that is still registered
+     */
+    ~gc_t();
 
     /**
      * Adds a reference to a pointer, giving back the amount of references to the pointer after the operation
      * Returns whether a new entry was created
      */
-    inline bool add_ref_ex( basik_val* v, size_t* count );
+    bool add_ref_ex( basik_val* v, size_t* count );
 
     /**
      * Adds a reference to a pointer
      */ 
-    inline bool add_ref( basik_val* v );
+    bool add_ref( basik_val* v );
 
     /**
      * Removes a reference to a pointer, giving back the amount of references to the pointer after the operation
@@ -269,6 +640,931 @@ struct gc_t {
     /**
      * Destroys all objects that are no longer used
      */
-    inline size_t collect( void );
+    size_t collect( void );
+
+private:
+
+    /**
+     * Gives back the slot of `index` that refers to the entry of `v`, or the empty slot where it would go
+     */
+    size_t* slot_of( basik_val* v );
+
+    /**
+     * Removes the entry at `pos` of `refs` along with its slot, the last entry takes its place
+     */
+    void erase( size_t pos, size_t* slot );
+
+};
+
+/**
+ * The table of interned strings, an open-addressed hash set of `String` values
+ * Its values hold a reference in the GC that is never removed, so they live as long as the program
+ */
+struct StringTable {
+
+    gc_t* gc;
+    basik_val** slots;
+    size_t cap;
+    size_t size;
+
+    StringTable(gc_t* gc);
+    ~StringTable();
+
+    /**
+     * Finds the interned string with the provided contents, creating it if it doesn't exist yet
+     * NOTE: The data is not copied, so it has to outlive the table
+     */
+    basik_val* intern(size_t len, const char* data);
+
+};
+
+// VM Structures //
+
+struct CodeObj {
+    const char* full_name;
+    Stack<const char*> tags;
+    const char* type;
+    const char* name;
+    uint8_t* data;
+    size_t data_sz;
+    Code* code;
+    // Whether the top-level code of the module was ran by an `Import` instruction
+    bool imported;
+};
+
+/**
+ * A structure used to store global data that can be accessed across scopes.
+ * NOTE: It might be a little bit costy, so it should be used as little as possible.
+ * NOTE: For now it pretty much behaves like dynvars, except that is values can be used multiple times.
+ */
+struct Globals {
+
+    gc_t* gc;
+    Stack<basik_var> vars;
+    StringTable strings;
+    // Changes whenever a global is set, the values cached by LoadGlobal instructions are only valid for one version
+    uint64_t version;
+    // Whether the host defined functions (see `VM::define`), which isolates do not have
+    bool host_functions;
+    // Whether these are the globals of an isolate, which cannot be set since the program would not see it
+    bool isolated;
+    // The standard output and input of the VM, which it owns (isolates have none)
+    Output* output;
+    Input* input;
+
+    Globals(gc_t* gc) : strings(gc) {
+        this->gc = gc;
+        this->version = 1;
+        this->host_functions = false;
+        this->isolated = false;
+        this->output = nullptr;
+        this->input = nullptr;
+    }
+
+    void set(const char* name, basik_val* value) {
+        version++;
+        gc->add_ref(value);
+        for (size_t i = 0; i < vars.size; i++) {
+            basik_var& vv = vars.data[i];
+            if (vv.name != nullptr && !strcmp(vv.name,name)) {
+                gc->remove_ref(vv.data);
+                vv.data = value;
+                return;
+            }
+        }
+        for (size_t i = 0; i < vars.size; i++) {
+            if (vars.data[i].name == nullptr) {
+                vars.data[i] = basik_var{value,name};
+                return;
+            }
+        }
+        vars.push(basik_var{value,name});
+    }
+
+    basik_val* get(const char* name) {
+        for (size_t i = 0; i < vars.size; i++) {
+            basik_var& v = vars.data[i];
+            if (v.name != nullptr && !strcmp(v.name,name)) {
+                return v.data;
+            }
+        }
+        return nullptr;
+    }
+
+};
+
+/**
+ * The objects of a program, found by their name through a hash table
+ * Linked images (what the compiler writes) store the table, which is built when they are loaded otherwise,
+ * and objects are only decoded the first time they are looked up, the stack holds them in the order they were
+ */
+struct ObjectTable : Stack<CodeObj*> {
+
+    // An empty slot has an offset of 0
+    struct symbol {
+        uint64_t hash;
+        uint64_t offset;
+    };
+
+    gc_t* gc;
+    Globals* glob;
+    const uint8_t* image;
+    size_t image_sz;
+    const symbol* symbols;
+    size_t symbols_cap;
+    // The object of every slot of the table, once it was decoded
+    CodeObj** decoded;
+    // The table that this one is a copy of, for isolates
+    ObjectTable* from;
+
+    ObjectTable(gc_t* gc, Globals* glob);
+
+    /**
+     * Creates an empty copy of a table, whose objects are decoded again for the GC and globals of an isolate
+     */
+    ObjectTable(gc_t* gc, Globals* glob, ObjectTable* from);
+
+    /**
+     * Frees the objects that were decoded, their values belong to the GC
+     */
+    ~ObjectTable();
+
+    /**
+     * Loads the table of an image, `entry` is set to the object tagged `main`
+     * Returns false if the image is malformed
+     */
+    bool load(const uint8_t* image, size_t sz, CodeObj** entry);
+
+    /**
+     * Finds an object by its full name, decoding it if it was not yet
+     * Returns `nullptr` if there is no such object, or if it is malformed
+     */
+    CodeObj* find(const char* name);
+
+    /**
+     * Decodes every object, for what needs to know all of them upfront (perf support, ahead-of-time compilation)
+     * Returns false if one of them is malformed
+     */
+    bool load_all();
+
+    /**
+     * Decodes the object of a slot of the table
+     */
+    CodeObj* decode(size_t slot);
+
+};
+
+/**
+ * What a LoadGlobal or a Call instruction resolved the last time it was executed,
+ * every one of them has its own, numbered by the compiler
+ */
+struct inline_cache {
+    // LoadGlobal: the value of the global as of `version` of the globals
+    // Call: the function that was called, which the cache holds a reference to so that its address is not reused
+    basik_val* value;
+    uint64_t version;
+    // Call: what the function resolved to
+    Code* code;
+    Result(*callback)(Code*,size_t,basik_val**);
+};
+
+struct Code {
+
+    bool initialized;
+
+    // How many calls of the object are running, a call made while it is running
+    // (recursion) runs on a fork, which has its own stack and variables (see `fork`)
+    size_t depth;
+    Stack<Code*> forks;
+
+    // The inline caches of the object, shared with its forks
+    inline_cache* caches;
+    uint32_t caches_sz;
+
+    // Sized to the maximum depth the compiler found the stack of the object can reach
+    basik_val** stack;
+    uint32_t stack_sz;
+    size_t stacki;
+    
+    Stack<size_t> list_stack;
+    basik_var** simple_vars;
+    uint32_t simple_vars_sz;
+    Stack<basik_var> dynamic_vars;
+    Globals* glob;
+    const_data_t** const_data;
+    uint32_t const_data_sz;
+
+    const char* bytecode;
+    // The size of the whole object (header included), nothing past it is read
+    size_t bytecode_sz;
+    uint8_t* ptr;
+    uint8_t* orig;
+    uint8_t* prog;
+
+    ObjectTable* objects;
+    CodeObj* obj;
+
+    gc_t* gc;
+
+    // The line table of the object, only decoded when it is needed (see `get_line`)
+    const uint8_t* lines;
+    uint32_t lines_sz;
+    // Address to line map, built on demand by `line_map_get`
+    uint32_t* line_map;
+    size_t line_map_sz;
+
+    // The native entry point of the object when perf support is enabled (see `Perf`)
+    Result(*trampoline)(Code*,Result(*)(Code*));
+    // The ahead-of-time compiled version of the object, ran instead of `run` (see `aot.cpp`)
+    Result(*native)(Code*);
+    // Whether a call of the object failed in an isolate, the parallel builtins then always call it on the calling thread
+    bool serial;
+
+    Code( gc_t* gc, Globals* glob, const char* bytecode, size_t bytecode_sz, ObjectTable* objects ) {
+        this->stack = nullptr;
+        this->stack_sz = 0;
+        this->stacki = 0;
+        this->gc = gc;
+        this->bytecode = bytecode;
+        this->bytecode_sz = bytecode_sz;
+        this->glob = glob;
+        this->initialized = false;
+        this->objects = objects;
+        this->obj = nullptr;
+        this->lines = nullptr;
+        this->lines_sz = 0;
+        this->line_map = nullptr;
+        this->line_map_sz = 0;
+        this->trampoline = nullptr;
+        this->native = nullptr;
+        this->serial = false;
+        this->depth = 0;
+        this->simple_vars = nullptr;
+        this->simple_vars_sz = 0;
+        this->const_data = nullptr;
+        this->const_data_sz = 0;
+        this->caches = nullptr;
+        this->caches_sz = 0;
+    }
+
+    /**
+     * Frees the stack, variables and forks of the object, along with the decoded data when it is not a fork
+     */
+    ~Code() {
+        for (size_t i = 0; i < forks.size; i++) delete forks.data[i];
+        for (uint32_t i = 0; i < simple_vars_sz; i++) delete simple_vars[i];
+        delete[] simple_vars;
+        delete[] stack;
+        delete[] line_map;
+        // Forks share the constants and inline caches of the object they were made from
+        if (obj != nullptr && obj->code != this) return;
+        for (uint32_t i = 0; i < const_data_sz; i++) delete const_data[i];
+        delete[] const_data;
+        delete[] caches;
+    }
+
+    /**
+     * Gives back an idle copy of the (initialized) object that shares its bytecode and decoded data,
+     * forks are reused once the call they were made for returns (see `call_code_with`)
+     */
+    Code* fork() {
+        if (forks.size) return forks.pop();
+        Code* c = new Code(gc,glob,bytecode,bytecode_sz,objects);
+        c->obj = obj;
+        c->const_data = const_data;
+        c->const_data_sz = const_data_sz;
+        c->caches = caches;
+        c->caches_sz = caches_sz;
+        c->stack_sz = stack_sz;
+        c->stack = new basik_val*[stack_sz];
+        c->simple_vars_sz = simple_vars_sz;
+        c->simple_vars = new basik_var*[simple_vars_sz];
+        for (uint32_t i = 0; i < simple_vars_sz; i++) c->simple_vars[i] = new basik_var{nullptr,simple_vars[i]->name};
+        c->ptr = ptr;
+        c->orig = orig;
+        c->prog = orig;
+        c->lines = lines;
+        c->lines_sz = lines_sz;
+        c->trampoline = trampoline;
+        c->native = native;
+        c->initialized = true;
+        return c;
+    }
+
+    /**
+     * Retreives the path of the source file the object was compiled from
+     * returns `nullptr` if the object has no line information
+     */
+    const char* get_source() {
+        if (lines_sz == 0) return nullptr;
+        return (const char*)lines;
+    }
+
+    /**
+     * Retreives the source line of the instruction at the provided address by walking the line table
+     * returns 0 if the object has no line information
+     */
+    uint32_t get_line(size_t addr) {
+        if (lines_sz == 0) return 0;
+        const uint8_t* p = lines + strlen((const char*)lines) + 1;
+        const uint8_t* e = lines + lines_sz;
+        uint32_t line = *(uint32_t*)p; p += 4;
+        size_t a = 0;
+        for (; p+1 < e; p += 2) {
+            a += p[0];
+            if (a > addr) break;
+            line += (int8_t)p[1];
+        }
+        return line;
+    }
+
+    /**
+     * Same as `get_line`, but decodes the whole line table the first time it is called
+     * so that subsequent lookups do not have to walk the table
+     */
+    uint32_t line_map_get(size_t addr) {
+        if (lines_sz == 0) return 0;
+        if (line_map == nullptr) {
+            const uint8_t* p = lines + strlen((const char*)lines) + 1;
+            const uint8_t* e = lines + lines_sz;
+            uint32_t line = *(uint32_t*)p; p += 4;
+            size_t a = 0;
+            for (const uint8_t* q = p; q+1 < e; q += 2) a += q[0];
+            line_map_sz = a+1;
+            line_map = new uint32_t[line_map_sz];
+            a = 0;
+            for (; p+1 < e; p += 2) {
+                for (size_t i = a; i < a+p[0]; i++) line_map[i] = line;
+                a += p[0];
+                line += (int8_t)p[1];
+            }
+            line_map[a] = line;
+        }
+        if (addr >= line_map_sz) return line_map[line_map_sz-1];
+        return line_map[addr];
+    }
+
+    /**
+     * Sets a dynamic variable with the provided name to the provided value
+     */
+    void dynvar_set(const char* name, basik_val* value) {
+        gc->add_ref(value);
+        for (size_t i = 0; i < dynamic_vars.size; i++) {
+            basik_var& vv = dynamic_vars.data[i];
+            if (vv.name != nullptr && !strcmp(vv.name,name)) {
+                gc->remove_ref(vv.data);
+                vv.data = value;
+                return;
+            }
+        }
+        // Tries to find an empty space in the variables
+        for (size_t i = 0; i < dynamic_vars.size; i++) {
+            if (dynamic_vars.data[i].name == nullptr) {
+                dynamic_vars.data[i] = basik_var{value,name};
+                return;
+            }
+        }
+        // Adds a new one if no space was found
+        dynamic_vars.push(basik_var{value,name});
+    }
+
+    /**
+     * Finds a dynamic variable with the provided name
+     * returns `nullptr` if it wasn't found
+     */
+    basik_val* dynvar_get(const char* name) {
+        for (size_t i = 0; i < dynamic_vars.size; i++) {
+            basik_var& v = dynamic_vars.data[i];
+            if (v.name != nullptr && !strcmp(v.name,name)) {
+                return v.data;
+            }
+        }
+        return nullptr;
+    }
+
+    bool dynvar_rem(const char* name) {
+        for (size_t i = 0; i < dynamic_vars.size; i++) {
+            basik_var& v = dynamic_vars.data[i];
+            if (v.name != nullptr && !strcmp(v.name,name)) {
+                gc->remove_ref(v.data);
+                v = basik_var{nullptr,nullptr};
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The stack is never checked, it is large enough for what the bytecode of the object pushes
+    inline void stack_push(basik_val* v) {
+        gc->add_ref(v);
+        stack[stacki++] = v;
+    }
+
+    inline basik_val* stack_pop() {
+        basik_val* v = stack[--stacki];
+        gc->remove_ref(v);
+        return v;
+    }
+
+    bool is_val_true(basik_val* v) {
+        if (v == nullptr) return false;
+        if (v->type == DataType::Char)   return *((BasikChar*)v->data)->data       != 0;
+        if (v->type == DataType::I16)    return *((BasikI16*)v->data)->data        != 0;
+        if (v->type == DataType::I32)    return *((BasikI32*)v->data)->data        != 0;
+        if (v->type == DataType::I64)    return *((BasikI64*)v->data)->data        != 0;
+        if (v->type == DataType::I64)    return *((BasikI64*)v->data)->data        != 0;
+        if (v->type == DataType::List)   return  ((BasikList*)v->data)->size       != 0;
+        if (v->type == DataType::Dict)   return  ((BasikDict*)v->data)->size       != 0;
+        if (v->type == DataType::Array)  return  ((BasikArray*)v->data)->size      != 0;
+        if (v->type == DataType::String) return  ((BasikString*)v->data)->len      >  1;
+        if (v->type == DataType::Bool)   return *((BasikBool*)v->data)->data;
+        return false;
+    }
+
+};
+
+/**
+ * A line-level profiler, attributes the time spent and the values allocated between
+ * two instructions to the source line of the first one
+ */
+struct Profiler {
+
+    struct prof_line {
+        uint64_t instrs;
+        uint64_t ns;
+        size_t allocs;
+    };
+
+    struct prof_file {
+        const char* source;
+        // Indexed by line number
+        Stack<prof_line*> lines;
+    };
+
+    gc_t* gc;
+    Stack<prof_file*> files;
+
+    // What is currently being executed
+    Code* cur_code;
+    prof_file* cur_file;
+    prof_line* cur;
+
+    // The state at the start of the current instruction
+    uint64_t t;
+    size_t allocs;
+
+    Profiler(gc_t* gc);
+
+    static uint64_t now();
+
+    prof_file* get_file(const char* source);
+
+    prof_line* get_line(prof_file* f, uint32_t line);
+
+    /**
+     * Ends the current measurement, attributing it to the current line
+     */
+    void flush();
+
+    /**
+     * Called before an instruction gets executed
+     */
+    void step(Code* code, size_t addr);
+
+    /**
+     * Prints the time spent, instructions executed and values allocated for every line that was executed
+     */
+    void report(FILE* out);
+
+};
+
+/**
+ * A frame of the VM, while perf support is enabled they are chained on the native stack
+ * from `basik_frame_top` so that external tools (gdb, bpftrace...) can walk the VM call stack
+ */
+struct vm_frame {
+    vm_frame* prev;
+    const char* name;
+    Code* code;
+};
+
+extern "C" vm_frame* volatile basik_frame_top;
+
+/**
+ * Linux perf support, gives every object its own small native trampoline that calls `run`
+ * and lists them in `/tmp/perf-<pid>.map`, so that samples taken while running an object are
+ * attributed to its name when walking frame pointers
+ */
+struct Perf {
+
+    uint8_t* mem;
+    size_t mem_sz;
+
+    Perf();
+
+    /**
+     * Creates the trampolines of all the provided objects
+     * Returns whether they could be created, objects are simply ran directly otherwise
+     */
+    bool load(Stack<CodeObj*>* objects);
+
+};
+
+/**
+ * The buffered output of the VM, everything `print` writes goes through it and it is only
+ * written to the underlying file once it is full, when `flush` is called, or after every line
+ * when it is line-buffered (used for interactive sessions)
+ */
+struct Output {
+
+    FILE* file;
+    uint8_t* buf;
+    size_t size;
+    size_t cap;
+    bool line_buffered;
+
+    Output(FILE* file, size_t cap);
+    ~Output();
+
+    void write(const void* data, size_t sz);
+
+    inline void put(uint8_t c) {
+        if (size == cap) flush();
+        buf[size++] = c;
+    }
+
+    inline void write_str(const char* s) {
+        write(s,strlen(s));
+    }
+
+    /**
+     * Writes an integer in base 10 without going through printf
+     */
+    void write_i64(int64_t v);
+
+    /**
+     * Ends the current line, flushing the output if it is line-buffered
+     */
+    inline void newline() {
+        put('\n');
+        if (line_buffered) flush();
+    }
+
+    void flush();
+
+};
+
+/**
+ * A buffered line reader, lines are read into large blocks and given back as views into them,
+ * so reading a line does not copy or allocate its data
+ * A block is reused once no string points into it anymore, otherwise a new one is started
+ */
+struct Input {
+
+    FILE* file;
+    BasikStringBuf* block;
+    // Where the unread data starts in the block
+    size_t pos;
+    // Up to where the unread data was already searched for a line break
+    size_t scan;
+    bool eof;
+
+    Input(FILE* file, size_t cap);
+    ~Input();
+
+    /**
+     * Reads the next line, including its line break if it has one
+     * Returns `nullptr` at the end of the file
+     */
+    BasikString* readline();
+
+    /**
+     * Reads everything that is left
+     */
+    BasikString* read_all();
+
+private:
+    /**
+     * Reads more data at the end of the block, making room for it first
+     * Returns whether anything was read
+     */
+    bool fill();
+
+};
+
+// Immortal values //
+
+// The range of integers that are preallocated for every integer type
+const int64_t SMALL_INT_MIN = -128;
+const int64_t SMALL_INT_MAX = 1023;
+const size_t  SMALL_INT_COUNT = SMALL_INT_MAX-SMALL_INT_MIN+1;
+
+// Where each kind of value starts in `immortals`
+const size_t IMMORTAL_BOOL  = 0;
+const size_t IMMORTAL_CHAR  = IMMORTAL_BOOL+2;
+const size_t IMMORTAL_I16   = IMMORTAL_CHAR+256;
+const size_t IMMORTAL_I32   = IMMORTAL_I16+SMALL_INT_COUNT;
+const size_t IMMORTAL_I64   = IMMORTAL_I32+SMALL_INT_COUNT;
+const size_t IMMORTAL_COUNT = IMMORTAL_I64+SMALL_INT_COUNT;
+
+/**
+ * Preallocated values for `False`, `True`, every Char and the small integers of every width
+ * They are shared by everything (isolates included), the GC ignores them and they are never freed,
+ * so they must never be modified or deleted
+ */
+extern basik_val* const immortals;
+
+inline bool is_immortal(basik_val* v) {
+    return (uintptr_t)v-(uintptr_t)immortals < IMMORTAL_COUNT*sizeof(basik_val);
+}
+
+inline basik_val* val_bool(bool v) {
+    return &immortals[IMMORTAL_BOOL+v];
+}
+
+inline basik_val* val_char(uint8_t v) {
+    return &immortals[IMMORTAL_CHAR+v];
+}
+
+// The integer constructors give back an immortal value when there is one, and allocate a new one otherwise
+
+inline basik_val* val_i16(int16_t v) {
+    if (v >= SMALL_INT_MIN && v <= SMALL_INT_MAX) return &immortals[IMMORTAL_I16+(v-SMALL_INT_MIN)];
+    return new basik_val{DataType::I16,new BasikI16(v)};
+}
+
+inline basik_val* val_i32(int32_t v) {
+    if (v >= SMALL_INT_MIN && v <= SMALL_INT_MAX) return &immortals[IMMORTAL_I32+(v-SMALL_INT_MIN)];
+    return new basik_val{DataType::I32,new BasikI32(v)};
+}
+
+inline basik_val* val_i64(int64_t v) {
+    if (v >= SMALL_INT_MIN && v <= SMALL_INT_MAX) return &immortals[IMMORTAL_I64+(v-SMALL_INT_MIN)];
+    return new basik_val{DataType::I64,new BasikI64(v)};
+}
+
+// VM //
+
+// The line-level profiler, enabled with `--profile`
+extern Profiler* profiler;
+// Perf support, enabled with `--perf`
+extern Perf* perf;
+// The amount of instructions that have been executed by the current thread
+// (the parallel builtins add the ones of their workers to the thread that called them)
+extern thread_local uint64_t instr_count;
+
+/**
+ * Reads the header of an object and verifies its bytecode (see `verify`), does nothing if it was already done
+ * gives back an exception if the object is malformed, in which case it can not be ran
+ */
+Result pre_run(Code* code);
+
+/**
+ * Gives back the size of the instruction at `p` (operands included), or 0 if it is unknown or does not fit before `end`
+ */
+size_t instr_size(const uint8_t* p, const uint8_t* end);
+
+/**
+ * Runs an object from its first instruction
+ */
+Result run(Code* code);
+
+/**
+ * Runs a code object, through its trampoline and with a VM frame when perf support is enabled
+ */
+Result call_code(Code* code);
+
+/**
+ * Calls a code object with a list of arguments (what the `Call` instruction does),
+ * on a fork of it if it is already running
+ */
+Result call_code_with(Code* code, basik_val* args);
+
+/**
+ * Creates the exception of a builtin, without a frame: the `Call` instruction that ran the builtin adds the one of its caller
+ * the text is formatted like `printf` does
+ */
+Result builtin_error(Code* code, const char* fmt, ...) __attribute__((format(printf,2,3)));
+
+/**
+ * Retreives the name of the type of a value, `NULL` included
+ */
+const char* type_name(basik_val* v);
+
+/**
+ * Reads an integer out of a Char, I16, I32, I64 or Bool value, returns false for any other type
+ */
+bool int_value(basik_val* v, int64_t* out);
+
+// Arrays (array.cpp) //
+
+/**
+ * The comparisons supported by `array_compare`, `array_filter` and the `JumpIfNotCmp` instruction
+ */
+enum ArrayCmp : uint8_t {
+    CmpEq,
+    CmpNe,
+    CmpLt,
+    CmpLe,
+    CmpGt,
+    CmpGe
+};
+
+/**
+ * Applies `+`, `-` or `*` element-wise between two arrays of the same type and size
+ */
+BasikArray* array_binop(char op, BasikArray* a, BasikArray* b);
+
+/**
+ * Applies `+`, `-` or `*` between every element of an array and a scalar,
+ * `reversed` computes `s op a[i]` instead of `a[i] op s`
+ */
+BasikArray* array_binop_scalar(char op, BasikArray* a, int64_t s, bool reversed);
+
+/**
+ * Implements the arithmetic instructions when one of their operands is an array
+ */
+Result array_arith(Code* code, size_t instr, char op, basik_val* a, basik_val* b);
+
+int64_t array_sum(BasikArray* a);
+// NOTE: `array_min` and `array_max` expect a non-empty array
+int64_t array_min(BasikArray* a);
+int64_t array_max(BasikArray* a);
+
+/**
+ * Gives back an array of the same type holding 1 where `a[i] cmp s` and 0 elsewhere
+ */
+BasikArray* array_compare(BasikArray* a, ArrayCmp cmp, int64_t s);
+
+/**
+ * Gives back an array of the elements for which `a[i] cmp s`
+ */
+BasikArray* array_filter(BasikArray* a, ArrayCmp cmp, int64_t s);
+
+/**
+ * The instruction set the kernels were dispatched to on this machine
+ */
+const char* array_isa();
+
+// Parallel builtins (parallel.cpp) //
+
+/**
+ * A copy of the VM that the callbacks of the parallel builtins run in on a worker thread
+ * It has its own GC, globals and copy of every object, and the values given to it are copied,
+ * so that it never touches anything owned by the main thread
+ */
+struct Isolate {
+    gc_t* gc;
+    Globals* glob;
+    // Copies of the objects of the program, decoded when they are first needed
+    ObjectTable* objects;
+
+    Isolate(ObjectTable* from);
+    ~Isolate();
+
+    /**
+     * Gives the isolate the functions defined in `from`, along with the builtins that do not use shared state
+     */
+    void sync(Globals* from);
+
+    /**
+     * Finds the copy of an object of the program
+     * returns `nullptr` if it does not belong to the program
+     */
+    Code* find(Code* code);
+};
+
+/**
+ * Copies a value so that it can be handed to another isolate, the elements of lists are copied as well
+ * Returns false for values that cannot be copied (Dicts, Files, Functions)
+ */
+bool isolate_copy(basik_val* v, basik_val** out);
+
+/**
+ * Whether `isolate_copy` can copy a value
+ */
+bool isolate_copyable(basik_val* v);
+
+/**
+ * Frees the isolates of a program, which has to be done before its objects are
+ */
+void parallel_release(ObjectTable* objects);
+
+/**
+ * The amount of threads the parallel builtins use, read from `BASIK_THREADS` (the amount of cores by default)
+ */
+size_t parallel_threads();
+
+/**
+ * `filter(f, list)`, calls `f` on chunks of the list in parallel when it is large enough
+ */
+Result list_filter(Code* code, BasikFunction* f, BasikList* l);
+
+/**
+ * `sum(list)` for lists of integers, sums chunks of the list in parallel when it is large enough
+ */
+Result list_sum(Code* code, BasikList* l);
+
+// Host API (vm.cpp) //
+
+/**
+ * A program along with everything needed to run it, for programs that embed Basik (the CLI is one of them)
+ * VMs are independent from each other and can be used from different threads, one thread per VM at a time
+ * NOTE: Every VM has its own buffers for the standard output and input (see `Globals`), which are not locked,
+ * so the output of VMs printing at the same time is only interleaved when their buffers are written out,
+ * and only one of them should read the standard input. The profiler and perf support are shared by all of them.
+ */
+struct VM {
+    gc_t* gc;
+    Globals* glob;
+    ObjectTable* objects;
+    // The object tagged `main`, that defines the functions of the program
+    Code* entry;
+
+    /**
+     * Creates an empty VM, with the builtins defined
+     */
+    VM();
+
+    /**
+     * Flushes the output and frees the program, its isolates and every value it still holds
+     */
+    ~VM();
+
+    /**
+     * Loads a compiled program (the content of a `.bsk` file), its objects are decoded when they are first used
+     * and used in place, so `image` must outlive the VM
+     * Returns false if the file is malformed or has no entry point, the bytecode of objects is verified before they first run
+     */
+    bool load(const uint8_t* image, size_t sz);
+
+    /**
+     * Defines a global function implemented by the host, which gets called like the builtins
+     * NOTE: Isolates do not have it, so the parallel builtins run their callbacks on the calling thread once one is defined.
+     */
+    void define(const char* name, Result(*callback)(Code*,size_t,basik_val**));
+
+    /**
+     * Verifies and runs the entry point, which has to be done before calling any function of the program
+     */
+    Result run();
+
+    /**
+     * Calls a global function with arguments, the same way the `Call` instruction does
+     * The result belongs to the GC of the VM, it has to be given a reference
+     * (`vm->gc->add_ref`) to be kept after another call
+     */
+    Result call(const char* name, size_t argc, basik_val** argv);
+};
+
+/**
+ * Prints an exception along with its trace, the innermost call last
+ */
+void print_exception(FILE* f, BasikException* e);
+
+// Ahead-of-time compilation (aot.cpp) //
+
+/**
+ * An object compiled ahead of time, they are listed in the order of the objects of the program
+ */
+struct aot_object {
+    Result(*native)(Code*);
+};
+
+/**
+ * Translates every object of a loaded program into a C++ function that does what `run` does with its bytecode,
+ * and writes them to `out` along with the program and a `main` that runs it with them (see `aot_main`)
+ * Returns false if one of the objects is malformed
+ */
+bool aot_translate(VM* vm, const uint8_t* image, size_t sz, const char* source, FILE* out);
+
+/**
+ * The entry point of a program compiled ahead of time, runs it like the CLI would, with its objects replaced by their compiled versions
+ */
+int aot_main(int argc, const char** argv, uint8_t* image, size_t sz, const aot_object* objects, size_t count);
+
+bool ends_with(const char* str, const char* end);
+bool has( Stack<const char*>& s, const char* v );
+void print_repr(Output* out, basik_val* v);
 
-};
\ No newline at end of file
+Result basik_std_print(Code* code, size_t argc, basik_val** argv);
+Result basik_std_input(Code* code, size_t argc, basik_val** argv);
+Result basik_std_join(Code* code, size_t argc, basik_val** argv);
+Result basik_std_flush(Code* code, size_t argc, basik_val** argv);
+Result basik_std_readline(Code* code, size_t argc, basik_val** argv);
+Result basik_std_lines(Code* code, size_t argc, basik_val** argv);
+Result basik_std_open(Code* code, size_t argc, basik_val** argv);
+Result basik_std_read(Code* code, size_t argc, basik_val** argv);
+Result basik_std_mmap_file(Code* code, size_t argc, basik_val** argv);
+Result basik_std_split(Code* code, size_t argc, basik_val** argv);
+Result basik_std_find(Code* code, size_t argc, basik_val** argv);
+Result basik_std_len(Code* code, size_t argc, basik_val** argv);
+Result basik_std_array(Code* code, size_t argc, basik_val** argv);
+Result basik_std_sum(Code* code, size_t argc, basik_val** argv);
+Result basik_std_min(Code* code, size_t argc, basik_val** argv);
+Result basik_std_max(Code* code, size_t argc, basik_val** argv);
+Result basik_std_compare(Code* code, size_t argc, basik_val** argv);
+Result basik_std_filter(Code* code, size_t argc, basik_val** argv);
+Result basik_std_map(Code* code, size_t argc, basik_val** argv);
+Result basik_std_reduce(Code* code, size_t argc, basik_val** argv);
+Result basik_std_sort(Code* code, size_t argc, basik_val** argv);
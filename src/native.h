@@ -0,0 +1,139 @@
+#pragma once
+
+#include "basik.h"
+
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+/**
+ * Bindings that turn plain C++ functions into builtins, for the programs that embed Basik
+ * It is kept out of `basik.h` so that the VM itself does not pull in the standard library headers it needs
+ */
+
+/**
+ * How `bind` gets the arguments of a native function out of values, `get` gives back false
+ * when a value does not have the right type, `type` is what the error says was expected
+ * Nothing is copied: strings are views into their data, arrays and lists are given as they are
+ * NOTE: Anything a native function is given only lives as long as the call, unless it adds a reference to it.
+ */
+template<typename T> struct native_arg;
+
+template<> struct native_arg<int64_t> {
+    static constexpr const char* type = "an integer";
+    static bool get(basik_val* v, int64_t* out) { return int_value(v,out); }
+};
+
+template<> struct native_arg<bool> {
+    static constexpr const char* type = "a Bool";
+    static bool get(basik_val* v, bool* out) {
+        if (v == nullptr || v->type != DataType::Bool) return false;
+        *out = *((BasikBool*)v->data)->data;
+        return true;
+    }
+};
+
+template<> struct native_arg<std::string_view> {
+    static constexpr const char* type = "a String";
+    static bool get(basik_val* v, std::string_view* out) {
+        if (v == nullptr || v->type != DataType::String) return false;
+        BasikString* s = (BasikString*)v->data;
+        *out = std::string_view((const char*)s->data,s->len-1);
+        return true;
+    }
+};
+
+template<> struct native_arg<BasikArray*> {
+    static constexpr const char* type = "an Array";
+    static bool get(basik_val* v, BasikArray** out) {
+        if (v == nullptr || v->type != DataType::Array) return false;
+        *out = (BasikArray*)v->data;
+        return true;
+    }
+};
+
+template<> struct native_arg<BasikList*> {
+    static constexpr const char* type = "a List";
+    static bool get(basik_val* v, BasikList** out) {
+        if (v == nullptr || v->type != DataType::List) return false;
+        *out = (BasikList*)v->data;
+        return true;
+    }
+};
+
+template<> struct native_arg<basik_val*> {
+    static constexpr const char* type = "a value";
+    static bool get(basik_val* v, basik_val** out) { *out = v; return true; }
+};
+
+/**
+ * How `bind` makes a value out of the result of a native function
+ * Returned strings are copied, their data usually belongs to the host
+ */
+template<typename T, typename = void> struct native_ret;
+
+template<typename T> struct native_ret<T,std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T,bool>>> {
+    static Result box(T v) { return Result{nullptr,val_i64((int64_t)v)}; }
+};
+
+template<> struct native_ret<bool> {
+    static Result box(bool v) { return Result{nullptr,val_bool(v)}; }
+};
+
+template<> struct native_ret<std::string_view> {
+    static Result box(std::string_view v) {
+        uint8_t* data = new uint8_t[v.size()+1];
+        memcpy(data,v.data(),v.size());
+        data[v.size()] = 0;
+        return Result{nullptr,new basik_val{DataType::String,BasikString::take(v.size()+1,data)}};
+    }
+};
+
+template<> struct native_ret<basik_val*> {
+    static Result box(basik_val* v) { return Result{nullptr,v}; }
+};
+
+// For native functions that raise their own errors (see `builtin_error`)
+template<> struct native_ret<Result> {
+    static Result box(Result r) { return r; }
+};
+
+template<typename R, typename ... A, typename F, size_t ... I>
+Result native_invoke(Code* code, size_t argc, basik_val** argv, F fn, std::index_sequence<I...>) {
+    if (argc != sizeof...(A)) return builtin_error(code,"Expected %zu arguments, got %zu",sizeof...(A),argc);
+    std::tuple<A...> args;
+    size_t bad = 0;
+    if (!((native_arg<A>::get(argv[I],&std::get<I>(args)) || (bad = I, false)) && ...)) {
+        const char* types[] = { native_arg<A>::type..., nullptr };
+        return builtin_error(code,"Argument %zu should be %s, got `%s`",bad+1,types[bad],type_name(argv[bad]));
+    }
+    if constexpr (std::is_void_v<R>) {
+        fn(std::get<I>(args)...);
+        return Result{nullptr,nullptr};
+    } else
+        return native_ret<R>::box(fn(std::get<I>(args)...));
+}
+
+template<auto F, typename R, typename ... A>
+Result native_call(R(*)(A...), Code* code, size_t argc, basik_val** argv) {
+    return native_invoke<R,std::decay_t<A>...>(code,argc,argv,[](A ... a) { return F(a...); },std::index_sequence_for<A...>{});
+}
+
+// Native functions that take the calling code first, to allocate values in its GC or raise errors
+template<auto F, typename R, typename ... A>
+Result native_call(R(*)(Code*,A...), Code* code, size_t argc, basik_val** argv) {
+    return native_invoke<R,std::decay_t<A>...>(code,argc,argv,[code](A ... a) { return F(code,a...); },std::index_sequence_for<A...>{});
+}
+
+template<auto F>
+Result native_fn(Code* code, size_t argc, basik_val** argv) {
+    return native_call<F>(F,code,argc,argv);
+}
+
+/**
+ * Makes a builtin out of a plain C++ function, the arguments are checked and unboxed
+ * and the result boxed by code generated for its signature (see `native_arg` and `native_ret`)
+ * e.g. `vm->define("repeat",bind<repeat>)` with `int64_t repeat(std::string_view s, int64_t n)`
+ */
+template<auto F>
+constexpr Result(*bind)(Code*,size_t,basik_val**) = native_fn<F>;
@@ -0,0 +1,464 @@
+#pragma once
+
+#include "basik.h"
+
+/**
+ * The instructions of the VM, shared by the interpreter (`run`) and the C++ generated by the
+ * ahead-of-time compiler (see `aot.cpp`) so that both behave the same
+ * They are given their operands already decoded, along with `instr` (the address right after their opcode),
+ * which the errors they give back point to
+ * NOTE: They rely on the bytecode having been verified (see `verify`), just like `run` does.
+ */
+
+#define BASIK_OP inline __attribute__((always_inline))
+
+// Store //
+
+BASIK_OP BasikException* op_store_simple(Code* code, size_t instr, uint32_t var) {
+    basik_val* val = code->stack_pop();
+    if (val == nullptr) return new BasikException("Got NULL for StoreSimple",instr,code);
+    if (code->simple_vars[var]->data != nullptr) code->gc->remove_ref(code->simple_vars[var]->data);
+    code->gc->add_ref(val);
+    code->simple_vars[var]->data = val;
+    return nullptr;
+}
+
+BASIK_OP BasikException* op_store_dynamic(Code* code, size_t instr, const char* varname) {
+    basik_val* val = code->stack_pop();
+    if (val == nullptr) return new BasikException("Got NULL for StoreDynamic",instr,code);
+    code->dynvar_set(varname,val);
+    return nullptr;
+}
+
+BASIK_OP BasikException* op_store_global(Code* code, size_t instr, const char* varname) {
+    basik_val* val = code->stack_pop();
+    if (val == nullptr) return new BasikException("Got NULL for StoreGlobal",instr,code);
+    if (code->glob->isolated) return new BasikException(instr,code,"Global `%s` cannot be set from a parallel callback",varname);
+    code->glob->set(varname,val);
+    return nullptr;
+}
+
+// Load //
+
+BASIK_OP BasikException* op_load_simple(Code* code, size_t instr, uint32_t var) {
+    basik_val* val = code->simple_vars[var]->data;
+    if (val == nullptr) return new BasikException(instr,code,"Undefined variable `%s`",code->simple_vars[var]->name);
+    code->stack_push(val);
+    return nullptr;
+}
+
+BASIK_OP BasikException* op_load_dynamic(Code* code, size_t instr, const char* varname) {
+    basik_val* val = code->dynvar_get(varname);
+    if (val == nullptr) return new BasikException(instr,code,"Undefined local variable `%s`",varname);
+    code->stack_push(val);
+    return nullptr;
+}
+
+BASIK_OP BasikException* op_load_global(Code* code, size_t instr, uint32_t cache, const char* varname) {
+    inline_cache& ic = code->caches[cache];
+    if (ic.version != code->glob->version) {
+        basik_val* val = code->glob->get(varname);
+        if (val == nullptr) return new BasikException(instr,code,"Undefined global variable `%s`",varname);
+        ic.value = val;
+        ic.version = code->glob->version;
+    }
+    code->stack_push(ic.value);
+    return nullptr;
+}
+
+BASIK_OP void op_load_function(Code* code, const char* id) {
+    // `verify` made sure that it exists
+    CodeObj* obj = code->objects->find(id);
+    code->stack_push(new basik_val{DataType::Function,new BasikFunction(obj->code)});
+}
+
+BASIK_OP BasikException* op_import(Code* code, size_t instr, const char* id) {
+    CodeObj* obj = code->objects->find(id);
+    if (obj->imported) return nullptr;
+    // Set first, so that modules that import each other do not loop
+    obj->imported = true;
+    Result r = pre_run(obj->code);
+    if (r.except == nullptr) r = call_code(obj->code);
+    if (r.except != nullptr) return r.except->add_trace(instr,code);
+    return nullptr;
+}
+
+// Lists and dicts //
+
+BASIK_OP void op_list_end(Code* code) {
+    size_t base = code->list_stack.pop();
+    size_t list_size = code->stacki-base;
+    BasikList* list = new BasikList();
+    list->reserve(list_size);
+    for (size_t i = 0; i < list_size; i++) {
+        code->gc->add_ref(code->stack[base+i]);
+        list->append(code->stack[base+i]);
+    }
+    for (size_t i = 0; i < list_size; i++) code->stack_pop();
+    code->stack_push(new basik_val{DataType::List,list});
+}
+
+BASIK_OP BasikException* op_dict_end(Code* code, size_t instr) {
+    size_t base = code->list_stack.pop();
+    size_t dict_size = code->stacki-base;
+    if (dict_size%2) return new BasikException(instr,code,"Attempt to close a dict with a key but no value");
+    BasikDict* dict = new BasikDict(code->gc,dict_size/2);
+    for (size_t i = 0; i < dict_size; i += 2) {
+        basik_val* k = code->stack[base+i];
+        if (!BasikDict::hashable(k)) {
+            delete dict;
+            return new BasikException(instr,code,"Unhashable key type `%s`",k == nullptr ? "NULL" : get_data_type_str(k->type));
+        }
+        dict->set(k,code->stack[base+i+1]);
+    }
+    for (size_t i = 0; i < dict_size; i++) code->stack_pop();
+    code->stack_push(new basik_val{DataType::Dict,dict});
+    return nullptr;
+}
+
+BASIK_OP BasikException* op_subscript(Code* code, size_t instr) {
+    basik_val* k = code->stack_pop();
+    basik_val* c = code->stack_pop();
+    if (c == nullptr) return new BasikException("Attempt to subscript NULL",instr,code);
+    if (c->type == DataType::Dict) {
+        if (!BasikDict::hashable(k)) return new BasikException(instr,code,"Unhashable key type `%s`",k == nullptr ? "NULL" : get_data_type_str(k->type));
+        BasikDict::slot* sl = ((BasikDict*)c->data)->find(k);
+        if (sl == nullptr) return new BasikException("Key not found",instr,code);
+        code->stack_push(sl->value);
+    } else if (c->type == DataType::List) {
+        if (k == nullptr || k->type != DataType::I64) return new BasikException(instr,code,"List indices must be I64, not `%s`",k == nullptr ? "NULL" : get_data_type_str(k->type));
+        BasikList* l = (BasikList*)c->data;
+        int64_t i = *((BasikI64*)k->data)->data;
+        if (i < 0) i += l->size;
+        if (i < 0 || (size_t)i >= l->size) return new BasikException("List index out of range",instr,code);
+        code->stack_push((*l)[i]);
+    } else if (c->type == DataType::Array) {
+        BasikArray* a = (BasikArray*)c->data;
+        int64_t i;
+        if (!int_value(k,&i)) return new BasikException(instr,code,"Array indices must be integers, not `%s`",type_name(k));
+        if (i < 0) i += a->size;
+        if (i < 0 || (size_t)i >= a->size) return new BasikException("Array index out of range",instr,code);
+        code->stack_push(a->box(i));
+    } else
+        return new BasikException(instr,code,"Attempt to subscript `%s`",get_data_type_str(c->type));
+    return nullptr;
+}
+
+BASIK_OP BasikException* op_store_subscript(Code* code, size_t instr) {
+    basik_val* k = code->stack_pop();
+    basik_val* c = code->stack_pop();
+    basik_val* v = code->stack_pop();
+    if (c == nullptr) return new BasikException("Attempt to subscript NULL",instr,code);
+    if (c->type == DataType::Dict) {
+        if (!BasikDict::hashable(k)) return new BasikException(instr,code,"Unhashable key type `%s`",k == nullptr ? "NULL" : get_data_type_str(k->type));
+        ((BasikDict*)c->data)->set(k,v);
+    } else if (c->type == DataType::List) {
+        if (k == nullptr || k->type != DataType::I64) return new BasikException(instr,code,"List indices must be I64, not `%s`",k == nullptr ? "NULL" : get_data_type_str(k->type));
+        BasikList* l = (BasikList*)c->data;
+        int64_t i = *((BasikI64*)k->data)->data;
+        if (i < 0) i += l->size;
+        if (i < 0 || (size_t)i >= l->size) return new BasikException("List index out of range",instr,code);
+        l->own(code->gc);
+        l->set(code->gc,i,v);
+    } else if (c->type == DataType::Array) {
+        BasikArray* a = (BasikArray*)c->data;
+        int64_t i, e;
+        if (!int_value(k,&i)) return new BasikException(instr,code,"Array indices must be integers, not `%s`",type_name(k));
+        if (!int_value(v,&e)) return new BasikException(instr,code,"Cannot store `%s` in an Array of %s",type_name(v),get_data_type_str(a->type));
+        if (!BasikArray::fits(a->type,e)) return new BasikException(instr,code,"Cannot store %lld in an Array of %s",(long long)e,get_data_type_str(a->type));
+        if (i < 0) i += a->size;
+        if (i < 0 || (size_t)i >= a->size) return new BasikException("Array index out of range",instr,code);
+        a->set(i,e);
+    } else
+        return new BasikException(instr,code,"Attempt to subscript `%s`",get_data_type_str(c->type));
+    return nullptr;
+}
+
+BASIK_OP BasikException* op_push_array(Code* code, size_t instr, DataType type, uint32_t size, const uint8_t* data) {
+    BasikArray* a = BasikArray::create(type,size);
+    if (a == nullptr) return new BasikException(instr,code,"Could not allocate an Array of %u elements",size);
+    memcpy(a->data,data,size*BasikArray::elem_size(type));
+    code->stack_push(new basik_val{DataType::Array,a});
+    return nullptr;
+}
+
+BASIK_OP BasikException* op_slice(Code* code, size_t instr) {
+    basik_val* hi = code->stack_pop();
+    basik_val* lo = code->stack_pop();
+    basik_val* c = code->stack_pop();
+    if (c == nullptr) return new BasikException("Attempt to slice NULL",instr,code);
+    size_t len;
+         if (c->type == DataType::List)   len = ((BasikList*)c->data)->size;
+    else if (c->type == DataType::String) len = ((BasikString*)c->data)->len-1;
+    else return new BasikException(instr,code,"Attempt to slice `%s`",get_data_type_str(c->type));
+    // Same bounds as python: negative indices count from the end, and out of range ones are clamped
+    int64_t b[2] = { 0, (int64_t)len };
+    basik_val* bv[2] = { lo, hi };
+    for (int j = 0; j < 2; j++) {
+        if (bv[j] == nullptr) continue;
+        if (!int_value(bv[j],&b[j])) return new BasikException(instr,code,"Slice indices must be integers, not `%s`",type_name(bv[j]));
+        if (b[j] < 0) b[j] += len;
+        if (b[j] < 0) b[j] = 0;
+        if (b[j] > (int64_t)len) b[j] = len;
+    }
+    size_t sz = b[1] > b[0] ? b[1]-b[0] : 0;
+    if (c->type == DataType::List)
+        code->stack_push(new basik_val{DataType::List,new BasikList((BasikList*)c->data,b[0],sz)});
+    else
+        code->stack_push(new basik_val{DataType::String,((BasikString*)c->data)->slice(b[0],sz)});
+    return nullptr;
+}
+
+// The list has to hold exactly as many values as the instruction expects, which the stack was sized for
+BASIK_OP BasikException* op_list_expand(Code* code, size_t instr, uint32_t n) {
+    basik_val* val = code->stack_pop();
+    if (val == nullptr) return new BasikException(instr,code,"Attempt to expand NULL");
+    if (val->type == DataType::List) {
+        BasikList& l = *(BasikList*)val->data;
+        if (l.size != n) return new BasikException(instr,code,"Expected %u values to expand, got %zu",n,l.size);
+        for (size_t i = 0; i < l.size; i++)
+            code->stack_push(l[i]);
+    } else
+        return new BasikException(instr,code,"Expand does not support type `%s`",get_data_type_str(val->type));
+    return nullptr;
+}
+
+// Arithmetic //
+
+template<char OP, typename T>
+inline auto arith_apply(T x, T y) {
+    if constexpr (OP == '+') return x+y;
+    else if constexpr (OP == '-') return x-y;
+    else if constexpr (OP == '*') return x*y;
+    else return x/y;
+}
+
+/**
+ * `+`, `-`, `*` and `/` between two integers of the same type, `+` also concatenates strings
+ * and all but `/` work on arrays (see `array_arith`)
+ */
+template<char OP>
+BASIK_OP BasikException* op_arith(Code* code, size_t instr) {
+    basik_val* b = code->stack_pop();
+    basik_val* a = code->stack_pop();
+    if (a == nullptr || b == nullptr) return new BasikException(instr,code,"Attempt to add NULL");
+    if (OP != '/' && (a->type == DataType::Array || b->type == DataType::Array)) {
+        Result r = array_arith(code,instr,OP,a,b);
+        if (r.except != nullptr) return r.except;
+        code->stack_push(r.value);
+    } else if (a->type == DataType::Char) {
+        if (b->type != DataType::Char) return new BasikException(instr,code,"Unsupported '%c' betwen Char and %s",OP,get_data_type_str(b->type));
+        code->stack_push(val_char(arith_apply<OP>(*((BasikChar*)a->data)->data,*((BasikChar*)b->data)->data)));
+    } else if (a->type == DataType::I16) {
+        if (b->type != DataType::I16) return new BasikException(instr,code,"Unsupported '%c' betwen I16 and %s",OP,get_data_type_str(b->type));
+        code->stack_push(val_i16(arith_apply<OP>(*((BasikI16*)a->data)->data,*((BasikI16*)b->data)->data)));
+    } else if (a->type == DataType::I32) {
+        if (b->type != DataType::I32) return new BasikException(instr,code,"Unsupported '%c' betwen I32 and %s",OP,get_data_type_str(b->type));
+        code->stack_push(val_i32(arith_apply<OP>(*((BasikI32*)a->data)->data,*((BasikI32*)b->data)->data)));
+    } else if (a->type == DataType::I64) {
+        if (b->type != DataType::I64) return new BasikException(instr,code,"Unsupported '%c' betwen I64 and %s",OP,get_data_type_str(b->type));
+        code->stack_push(val_i64(arith_apply<OP>(*((BasikI64*)a->data)->data,*((BasikI64*)b->data)->data)));
+    } else if (OP == '+' && a->type == DataType::String) {
+        if (b->type != DataType::String) return new BasikException(instr,code,"Unsupported '+' betwen String and %s",get_data_type_str(b->type));
+        code->stack_push(BasikString::concat(a,b));
+    } else
+        return new BasikException(instr,code,"Unsupported '%c' for `%s`\n",OP,get_data_type_str(a->type));
+    return nullptr;
+}
+
+// Comparisons //
+
+/**
+ * Compares two values the way the comparison instructions do, into `out`
+ * `==` and `!=` accept any value, orderings only accept integers (of any width) and strings
+ */
+BASIK_OP BasikException* compare_values(Code* code, size_t instr, ArrayCmp cmp, basik_val* a, basik_val* b, bool* out) {
+    static const char* ops[] = { "==", "!=", "<", "<=", ">", ">=" };
+    // Fast path for the most common case, integer loop bounds
+    if (a != nullptr && b != nullptr && a->type == DataType::I64 && b->type == DataType::I64) {
+        int64_t x = *((BasikI64*)a->data)->data, y = *((BasikI64*)b->data)->data;
+        switch (cmp) {
+            case CmpEq: *out = x == y; break;
+            case CmpNe: *out = x != y; break;
+            case CmpLt: *out = x <  y; break;
+            case CmpLe: *out = x <= y; break;
+            case CmpGt: *out = x >  y; break;
+            case CmpGe: *out = x >= y; break;
+        }
+        return nullptr;
+    }
+    int64_t s;
+    if ((a != nullptr && a->type == DataType::Array && int_value(b,&s)) || (b != nullptr && b->type == DataType::Array && int_value(a,&s)))
+        return new BasikException(instr,code,"Comparing an Array with '%s' gives an Array, which is neither true nor false",ops[cmp]);
+    if (cmp == CmpEq || cmp == CmpNe) {
+        bool eq;
+        if (a == nullptr || b == nullptr)
+            eq = a == b;
+        else if (a->type == DataType::Char || a->type == DataType::I16 || a->type == DataType::I32 || a->type == DataType::I64) {
+            if (b->type != a->type) return new BasikException(instr,code,"Unsupported '%s' betwen %s and %s",ops[cmp],get_data_type_str(a->type),get_data_type_str(b->type));
+            int64_t x, y;
+            int_value(a,&x);
+            int_value(b,&y);
+            eq = x == y;
+        } else if (a->type == DataType::String) {
+            if (b->type != DataType::String) return new BasikException(instr,code,"Unsupported '%s' betwen String and %s",ops[cmp],get_data_type_str(b->type));
+            eq = BasikString::equals((BasikString*)a->data,(BasikString*)b->data);
+        } else
+            eq = a == b;
+        *out = eq == (cmp == CmpEq);
+        return nullptr;
+    }
+    if (a == nullptr || b == nullptr) return new BasikException(instr,code,"Attempt to compare NULL with '%s'",ops[cmp]);
+    int c;
+    int64_t x, y;
+    if (int_value(a,&x) && int_value(b,&y))
+        c = x < y ? -1 : x > y;
+    else if (a->type == DataType::String && b->type == DataType::String) {
+        BasikString* sa = (BasikString*)a->data;
+        BasikString* sb = (BasikString*)b->data;
+        c = memcmp(sa->data,sb->data,(sa->len < sb->len ? sa->len : sb->len)-1);
+        if (c == 0) c = sa->len < sb->len ? -1 : sa->len > sb->len;
+    } else
+        return new BasikException(instr,code,"Unsupported '%s' betwen %s and %s",ops[cmp],get_data_type_str(a->type),get_data_type_str(b->type));
+    switch (cmp) {
+        case CmpLt: *out = c <  0; break;
+        case CmpLe: *out = c <= 0; break;
+        case CmpGt: *out = c >  0; break;
+        default:    *out = c >= 0; break;
+    }
+    return nullptr;
+}
+
+/**
+ * Pops two values and compares them into `out`, for the comparison instructions and `JumpIfNotCmp`
+ */
+BASIK_OP BasikException* op_compare(Code* code, size_t instr, ArrayCmp cmp, bool* out) {
+    basik_val* b = code->stack_pop();
+    basik_val* a = code->stack_pop();
+    return compare_values(code,instr,cmp,a,b,out);
+}
+
+/**
+ * Pops two values and pushes whether they compare, for the comparison instructions
+ * An array compared with an integer gives an array of 0 and 1 instead, one for each of its elements (see `array_compare`)
+ */
+BASIK_OP BasikException* op_compare_push(Code* code, size_t instr, ArrayCmp cmp) {
+    // What comparing the array on the right means with it on the left
+    static const ArrayCmp flipped[] = { CmpEq, CmpNe, CmpGt, CmpGe, CmpLt, CmpLe };
+    basik_val* b = code->stack_pop();
+    basik_val* a = code->stack_pop();
+    int64_t s;
+    if (a != nullptr && a->type == DataType::Array && int_value(b,&s)) {
+        code->stack_push(new basik_val{DataType::Array,array_compare((BasikArray*)a->data,cmp,s)});
+        return nullptr;
+    }
+    if (b != nullptr && b->type == DataType::Array && int_value(a,&s)) {
+        code->stack_push(new basik_val{DataType::Array,array_compare((BasikArray*)b->data,flipped[cmp],s)});
+        return nullptr;
+    }
+    bool t = false;
+    BasikException* e = compare_values(code,instr,cmp,a,b,&t);
+    if (e != nullptr) return e;
+    code->stack_push(val_bool(t));
+    return nullptr;
+}
+
+// Jumps //
+
+/**
+ * Steps the counter of a `for _ in range(...)` loop, `loop` tells whether it did not reach the end
+ */
+BASIK_OP BasikException* op_for_range(Code* code, size_t instr, uint32_t var, uint32_t stop, int64_t step, bool* loop) {
+    basik_val* cv = code->simple_vars[var]->data;
+    basik_val* sv = code->simple_vars[stop]->data;
+    int64_t c, s;
+    if (cv != nullptr && sv != nullptr && cv->type == DataType::I64 && sv->type == DataType::I64) {
+        c = *((BasikI64*)cv->data)->data;
+        s = *((BasikI64*)sv->data)->data;
+    } else if (!int_value(cv,&c))
+        return new BasikException(instr,code,"range() bounds must be integers, not `%s`",type_name(cv));
+    else if (!int_value(sv,&s))
+        return new BasikException(instr,code,"range() bounds must be integers, not `%s`",type_name(sv));
+    c += step;
+    *loop = step > 0 ? c < s : c > s;
+    if (*loop) {
+        basik_val* nv = val_i64(c);
+        code->gc->add_ref(nv);
+        code->gc->remove_ref(cv);
+        code->simple_vars[var]->data = nv;
+    }
+    return nullptr;
+}
+
+// Functions //
+
+BASIK_OP BasikException* op_call(Code* code, size_t instr, uint32_t cache) {
+    inline_cache& ic = code->caches[cache];
+    basik_val* vb = code->stack_pop();
+    basik_val* va = code->stack_pop();
+    if (vb == nullptr) return new BasikException("Attempt to call with NULL",instr,code);
+    if (vb->type != DataType::List) return new BasikException(instr,code,"Attempt to call with `%s`",get_data_type_str(vb->type));
+    // The function is only checked when it is not the one that was called from here the last time
+    if (va != ic.value) {
+        if (va == nullptr) return new BasikException("Attempt to call NULL",instr,code);
+        if (va->type != DataType::Function) return new BasikException(instr,code,"Attempt to call non-function `%s`",get_data_type_str(va->type));
+        BasikFunction* f = (BasikFunction*)va->data;
+        code->gc->add_ref(va);
+        if (ic.value != nullptr) code->gc->remove_ref(ic.value);
+        ic.value = va;
+        ic.code = f->code;
+        ic.callback = f->callback;
+    }
+    BasikList* args = (BasikList*)vb->data;
+    if (ic.code) {
+        Result r = call_code_with(ic.code,vb);
+        if (r.except != nullptr) return r.except->add_trace(instr,code);
+        code->stack_push(r.value);
+    } else if (ic.callback) {
+        // Builtins can run code that collects, the arguments are kept alive until they return
+        code->gc->add_ref(vb);
+        Result r = ic.callback(code,args->size,args->items());
+        code->gc->remove_ref(vb);
+        if (r.except != nullptr) return r.except->add_trace(instr,code);
+        code->stack_push(r.value);
+    }
+    return nullptr;
+}
+
+/**
+ * Pops the value returned by the object, it holds a reference until `op_leave` is done cleaning up
+ */
+BASIK_OP basik_val* op_return(Code* code) {
+    basik_val* v = code->stack_pop();
+    code->gc->add_ref(v);
+    return v;
+}
+
+/**
+ * Cleans the variables and the stack of an object up once it has returned `ret`
+ */
+BASIK_OP Result op_leave(Code* code, basik_val* ret) {
+    // Dynvars cleanup
+    for (size_t i = 0; i < code->dynamic_vars.size; i++) {
+        basik_var& v = code->dynamic_vars.data[i];
+        if (v.name != nullptr && v.data != nullptr) {
+            code->gc->remove_ref(v.data);
+            v = basik_var{nullptr,nullptr};
+        }
+    }
+
+    // Stack cleanup
+    for (size_t i = 0; i < code->stacki; i++)
+        code->gc->remove_ref(code->stack[i]);
+
+    code->stacki = 0;
+
+    code->gc->collect();
+    code->dynamic_vars.prune([](const basik_var& v) { return v.name == nullptr; });
+
+    // Removes the reference after the GC cleanup to make it live
+    // after the end of the call
+    if (ret) code->gc->remove_ref(ret);
+
+    return Result{nullptr,ret};
+}
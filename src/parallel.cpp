@@ -0,0 +1,644 @@
+#include "basik.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/********************************\
+*          Thread pool           *
+\********************************/
+
+// Below these sizes the builtins run on the calling thread, splitting the work costs more than it saves
+const size_t PARALLEL_MIN_CALLS  = 256;
+const size_t PARALLEL_MIN_NATIVE = 16384;
+
+// The builtins that isolates can call, the others use state shared with the main thread (output, input...)
+static const char* isolate_builtins[] = { "len", "join", "split", "find", "array", "sum", "min", "max", "compare" };
+
+// Whether the current thread is running tasks of the pool, the builtins called from them do not split their work again
+static thread_local bool in_pool = false;
+
+/**
+ * A fixed set of worker threads, `run` hands them a batch of tasks and runs tasks itself
+ * until the batch is over, so a pool of `size` workers keeps `size+1` threads busy
+ * Tasks are claimed one at a time from a shared counter, so uneven tasks still balance out
+ */
+struct ThreadPool {
+
+    std::thread* threads;
+    size_t size;
+
+    std::mutex lock;
+    std::mutex running;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    // The current batch
+    void(*fn)(void*,size_t,size_t);
+    void* ctx;
+    size_t tasks;
+    std::atomic<size_t> next;
+    size_t busy;
+    uint64_t batch;
+
+    // The instructions ran by the workers, added to the count of the calling thread after each batch
+    std::atomic<uint64_t> instrs;
+
+    ThreadPool(size_t size) : next(0), instrs(0) {
+        this->size = size;
+        this->fn = nullptr;
+        this->ctx = nullptr;
+        this->tasks = 0;
+        this->busy = 0;
+        this->batch = 0;
+        this->threads = new std::thread[size];
+        for (size_t i = 0; i < size; i++) this->threads[i] = std::thread(&ThreadPool::work,this,i+1);
+    }
+
+    /**
+     * Runs `fn(ctx,task,worker)` for every task in `[0,tasks)`, `worker` is 0 for the calling thread
+     * and goes up to `size` for the others, so it can index per-thread state
+     */
+    void run(size_t tasks, void(*fn)(void*,size_t,size_t), void* ctx) {
+        // Several VMs may be embedded in different threads, they take turns
+        std::lock_guard<std::mutex> b(this->running);
+        {
+            std::lock_guard<std::mutex> l(this->lock);
+            this->fn = fn;
+            this->ctx = ctx;
+            this->tasks = tasks;
+            this->next = 0;
+            this->busy = this->size;
+            this->batch++;
+        }
+        this->wake.notify_all();
+        in_pool = true;
+        for (size_t t; (t = this->next++) < tasks;) fn(ctx,t,0);
+        in_pool = false;
+        std::unique_lock<std::mutex> l(this->lock);
+        this->done.wait(l,[this]{ return this->busy == 0; });
+        instr_count += this->instrs.exchange(0);
+    }
+
+private:
+
+    void work(size_t worker) {
+        in_pool = true;
+        uint64_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> l(this->lock);
+                this->wake.wait(l,[&]{ return this->batch != seen; });
+                seen = this->batch;
+            }
+            for (size_t t; (t = this->next++) < this->tasks;) this->fn(this->ctx,t,worker);
+            this->instrs += instr_count;
+            instr_count = 0;
+            std::lock_guard<std::mutex> l(this->lock);
+            if (--this->busy == 0) this->done.notify_one();
+        }
+    }
+
+};
+
+static ThreadPool* pool = nullptr;
+static std::mutex pool_lock;
+
+// The isolates of every program that used the parallel builtins, one per thread of the pool
+struct program_isolates {
+    ObjectTable* objects;
+    Isolate** isolates;
+};
+static Stack<program_isolates> programs;
+
+size_t parallel_threads() {
+    static size_t n = 0;
+    if (n == 0) {
+        const char* env = getenv("BASIK_THREADS");
+        n = env != nullptr ? strtoull(env,nullptr,10) : std::thread::hardware_concurrency();
+        if (n == 0) n = 1;
+    }
+    return n;
+}
+
+static ThreadPool* get_pool() {
+    std::lock_guard<std::mutex> l(pool_lock);
+    if (pool == nullptr) pool = new ThreadPool(parallel_threads()-1);
+    return pool;
+}
+
+/**
+ * Gives back one isolate per thread of the pool for the program `code` belongs to,
+ * up to date with its globals
+ */
+static Isolate** get_isolates(Code* code) {
+    Isolate** isolates = nullptr;
+    {
+        std::lock_guard<std::mutex> l(pool_lock);
+        for (size_t i = 0; i < programs.size && isolates == nullptr; i++)
+            if (programs.data[i].objects == code->objects) isolates = programs.data[i].isolates;
+        if (isolates == nullptr) {
+            isolates = new Isolate*[parallel_threads()];
+            for (size_t i = 0; i < parallel_threads(); i++) isolates[i] = new Isolate(code->objects);
+            programs.push(program_isolates{code->objects,isolates});
+        }
+    }
+    for (size_t i = 0; i < parallel_threads(); i++) isolates[i]->sync(code->glob);
+    return isolates;
+}
+
+void parallel_release(ObjectTable* objects) {
+    Isolate** isolates = nullptr;
+    {
+        std::lock_guard<std::mutex> l(pool_lock);
+        for (size_t i = 0; i < programs.size; i++) {
+            if (programs.data[i].objects != objects) continue;
+            isolates = programs.data[i].isolates;
+            programs.data[i] = programs.data[--programs.size];
+            break;
+        }
+    }
+    if (isolates == nullptr) return;
+    for (size_t i = 0; i < parallel_threads(); i++) delete isolates[i];
+    delete[] isolates;
+}
+
+/**
+ * Whether `n` items are worth being split over the pool
+ */
+static bool can_split(size_t n, size_t min) {
+    return n >= min && parallel_threads() > 1 && !in_pool;
+}
+
+/**
+ * Whether calls to `f` can be spread over the pool, the profiler and perf support
+ * keep state about the running frame that is not per-thread, and the functions of the host may not be thread-safe
+ */
+static bool can_isolate(BasikFunction* f, size_t n) {
+    return f->code != nullptr && !f->code->serial && can_split(n,PARALLEL_MIN_CALLS) && profiler == nullptr && perf == nullptr && !f->code->glob->host_functions;
+}
+
+/********************************\
+*            Isolates            *
+\********************************/
+
+Isolate::Isolate(ObjectTable* from) {
+    this->gc = new gc_t();
+    this->glob = new Globals(this->gc);
+    this->glob->isolated = true;
+    this->objects = new ObjectTable(this->gc,this->glob,from);
+}
+
+Isolate::~Isolate() {
+    delete this->objects;
+    delete this->glob;
+    delete this->gc;
+}
+
+Code* Isolate::find(Code* code) {
+    if (code->objects != this->objects->from) return nullptr;
+    CodeObj* obj = this->objects->find(code->obj->full_name);
+    return obj != nullptr ? obj->code : nullptr;
+}
+
+void Isolate::sync(Globals* from) {
+    for (size_t i = 0; i < from->vars.size; i++) {
+        basik_var& v = from->vars.data[i];
+        if (v.name == nullptr || v.data == nullptr || v.data->type != DataType::Function) continue;
+        BasikFunction* f = (BasikFunction*)v.data->data;
+        basik_val* cur = this->glob->get(v.name);
+        if (f->code != nullptr) {
+            Code* code = this->find(f->code);
+            if (code == nullptr || (cur != nullptr && cur->type == DataType::Function && ((BasikFunction*)cur->data)->code == code)) continue;
+            this->glob->set(v.name,new basik_val{DataType::Function,new BasikFunction(code)});
+        } else if (cur == nullptr) {
+            for (const char* name : isolate_builtins) {
+                if (!strcmp(name,v.name)) {
+                    this->glob->set(v.name,new basik_val{DataType::Function,new BasikFunction(f->callback)});
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool isolate_copy(basik_val* v, basik_val** out) {
+    if (v == nullptr) { *out = nullptr; return true; }
+    if (v->type == DataType::Char)   { *out = new basik_val{DataType::Char,new BasikChar(*((BasikChar*)v->data)->data)}; return true; }
+    if (v->type == DataType::I16)    { *out = new basik_val{DataType::I16,new BasikI16(*((BasikI16*)v->data)->data)}; return true; }
+    if (v->type == DataType::I32)    { *out = new basik_val{DataType::I32,new BasikI32(*((BasikI32*)v->data)->data)}; return true; }
+    if (v->type == DataType::I64)    { *out = new basik_val{DataType::I64,new BasikI64(*((BasikI64*)v->data)->data)}; return true; }
+    if (v->type == DataType::Bool)   { *out = new basik_val{DataType::Bool,new BasikBool(*((BasikBool*)v->data)->data)}; return true; }
+    if (v->type == DataType::String) { *out = new basik_val{DataType::String,new BasikString(((BasikString*)v->data)->len,(const char*)((BasikString*)v->data)->data)}; return true; }
+    if (v->type == DataType::Array) {
+        BasikArray* a = (BasikArray*)v->data;
+        BasikArray* r = new BasikArray(a->type,a->size);
+        memcpy(r->data,a->data,a->size*BasikArray::elem_size(a->type));
+        *out = new basik_val{DataType::Array,r};
+        return true;
+    }
+    if (v->type == DataType::List) {
+        BasikList* l = (BasikList*)v->data;
+        BasikList* r = new BasikList();
+        r->reserve(l->size);
+        for (size_t i = 0; i < l->size; i++) {
+            basik_val* e;
+            if (!isolate_copy((*l)[i],&e)) {
+                delete r;
+                return false;
+            }
+            r->append(e);
+        }
+        *out = new basik_val{DataType::List,r};
+        return true;
+    }
+    return false;
+}
+
+bool isolate_copyable(basik_val* v) {
+    if (v == nullptr) return true;
+    if (v->type == DataType::List) {
+        BasikList* l = (BasikList*)v->data;
+        for (size_t i = 0; i < l->size; i++) if (!isolate_copyable((*l)[i])) return false;
+        return true;
+    }
+    return v->type == DataType::Char || v->type == DataType::I16 || v->type == DataType::I32 || v->type == DataType::I64
+        || v->type == DataType::Bool || v->type == DataType::String || v->type == DataType::Array;
+}
+
+/**
+ * Frees a copy made by `isolate_copy` that was never given to a GC
+ */
+static void isolate_free(basik_val* v) {
+    if (v == nullptr) return;
+    if (v->type == DataType::List) {
+        BasikList* l = (BasikList*)v->data;
+        for (size_t i = 0; i < l->size; i++) isolate_free((*l)[i]);
+    }
+    delete v;
+}
+
+/**
+ * Registers a value in a GC, along with the elements of the lists it contains, which lists hold a reference to
+ */
+static void adopt(gc_t* gc, basik_val* v) {
+    gc->add_ref(v);
+    if (v != nullptr && v->type == DataType::List) {
+        BasikList* l = (BasikList*)v->data;
+        for (size_t i = 0; i < l->size; i++) adopt(gc,(*l)[i]);
+    }
+}
+
+/**
+ * Calls a function with the provided arguments, the same way the `Call` instruction does
+ */
+static Result call_function(Code* code, BasikFunction* f, size_t argc, basik_val** argv) {
+    if (f->callback) return f->callback(code,argc,argv);
+    BasikList* args = new BasikList();
+    for (size_t i = 0; i < argc; i++) {
+        f->code->gc->add_ref(argv[i]);
+        args->append(argv[i]);
+    }
+    return call_code_with(f->code,new basik_val{DataType::List,args});
+}
+
+/**
+ * Calls the copy of a function in an isolate, the arguments are copied in and the result is copied out
+ * so that nothing the isolate allocates outlives the call
+ * When `truth` is provided, the result is not copied, only whether it is true is given back through it
+ */
+static Result isolate_call(Code* caller, Isolate* iso, Code* fn, size_t argc, basik_val** argv, bool* truth) {
+    basik_val* args[2];
+    for (size_t i = 0; i < argc; i++) {
+        if (!isolate_copy(argv[i],&args[i])) return builtin_error(caller,"`%s` cannot be passed to a parallel callback",type_name(argv[i]));
+        adopt(iso->gc,args[i]);
+    }
+    BasikFunction f(fn);
+    Result r = call_function(nullptr,&f,argc,args);
+    if (r.except == nullptr && truth != nullptr)
+        *truth = fn->is_val_true(r.value);
+    else if (r.except == nullptr && !isolate_copy(r.value,&r.value))
+        r = builtin_error(caller,"`%s` cannot be returned from a parallel callback",type_name(r.value));
+    for (size_t i = 0; i < argc; i++) iso->gc->remove_ref(args[i]);
+    iso->gc->collect();
+    return r;
+}
+
+/********************************\
+*            Builtins            *
+\********************************/
+
+/**
+ * The state shared by the tasks of a parallel callback, every task works on a chunk of `items`
+ */
+struct parallel_call {
+    Code* caller;
+    Isolate** isolates;
+    Code* fn;
+    basik_val** items;
+    size_t n;
+    size_t chunk;
+    // One result per item for `map` and `filter`, one per chunk for `reduce`
+    basik_val** results;
+    bool* keep;
+    BasikException** errors;
+};
+
+/**
+ * Splits `n` items in chunks, a few per thread so that a slow chunk does not hold the others back
+ */
+static size_t chunk_size(size_t n) {
+    size_t tasks = parallel_threads()*4;
+    return (n+tasks-1)/tasks;
+}
+
+static size_t chunk_count(size_t n, size_t chunk) {
+    return (n+chunk-1)/chunk;
+}
+
+/**
+ * Gives back the error of the first chunk that failed, if any
+ */
+static BasikException* first_error(BasikException** errors, size_t tasks) {
+    for (size_t i = 0; i < tasks; i++) if (errors[i] != nullptr) return errors[i];
+    return nullptr;
+}
+
+/**
+ * Gives up on a parallel call after some of its tasks failed, the errors and the results copied so far are dropped
+ * and the caller makes the calls again on its own thread, where they either succeed or fail the same way as without the pool
+ * (isolates cannot do anything the program sees, so nothing happens twice)
+ * `fn` is not split anymore, since it most likely uses something isolates do not have (I/O, globals, Dicts...)
+ */
+static void give_up(Code* fn, BasikException** errors, size_t tasks, basik_val** results, size_t n) {
+    for (size_t t = 0; t < tasks; t++) if (errors[t] != nullptr) delete errors[t];
+    for (size_t i = 0; i < n; i++) isolate_free(results[i]);
+    fn->serial = true;
+}
+
+/**
+ * Whether every item of a list can be given to isolates
+ */
+static bool items_copyable(BasikList* l) {
+    for (size_t i = 0; i < l->size; i++) if (!isolate_copyable((*l)[i])) return false;
+    return true;
+}
+
+/**
+ * Makes a list out of values, the list holds a reference to each of them like the ones made by `ListEnd`
+ */
+static basik_val* make_list(gc_t* gc, basik_val** items, size_t n, bool* keep) {
+    BasikList* l = new BasikList();
+    l->reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        if (keep != nullptr && !keep[i]) continue;
+        adopt(gc,items[i]);
+        l->append(items[i]);
+    }
+    return new basik_val{DataType::List,l};
+}
+
+static bool function_arg(basik_val* v) {
+    return v != nullptr && v->type == DataType::Function;
+}
+
+static bool list_arg(basik_val* v) {
+    return v != nullptr && v->type == DataType::List;
+}
+
+Result basik_std_map(Code* code, size_t argc, basik_val** argv) {
+    if (argc != 2) return builtin_error(code,"map() takes 2 arguments (%zu given)",argc);
+    if (!function_arg(argv[0])) return builtin_error(code,"map() expects a Function, got `%s`",type_name(argv[0]));
+    if (!list_arg(argv[1])) return builtin_error(code,"map() expects a List, got `%s`",type_name(argv[1]));
+    BasikFunction* f = (BasikFunction*)argv[0]->data;
+    BasikList* l = (BasikList*)argv[1]->data;
+    size_t n = l->size;
+    basik_val** results = new basik_val*[n]();
+    bool parallel = can_isolate(f,n) && items_copyable(l);
+    if (parallel) {
+        size_t chunk = chunk_size(n);
+        size_t tasks = chunk_count(n,chunk);
+        BasikException** errors = new BasikException*[tasks]();
+        parallel_call p{code,get_isolates(code),f->code,l->items(),n,chunk,results,nullptr,errors};
+        get_pool()->run(tasks,[](void* ctx, size_t t, size_t w) {
+            parallel_call& p = *(parallel_call*)ctx;
+            Code* fn = p.isolates[w]->find(p.fn);
+            for (size_t i = t*p.chunk; i < (t+1)*p.chunk && i < p.n; i++) {
+                Result r = isolate_call(p.caller,p.isolates[w],fn,1,&p.items[i],nullptr);
+                if (r.except != nullptr) { p.errors[t] = r.except; return; }
+                p.results[i] = r.value;
+            }
+        },&p);
+        if (first_error(errors,tasks) != nullptr) {
+            give_up(f->code,errors,tasks,results,n);
+            parallel = false;
+        }
+        delete[] errors;
+    }
+    if (!parallel) {
+        for (size_t i = 0; i < n; i++) {
+            Result r = call_function(code,f,1,&l->items()[i]);
+            if (r.except != nullptr) {
+                for (size_t j = 0; j < i; j++) code->gc->remove_ref(results[j]);
+                delete[] results;
+                return r;
+            }
+            // Keeps the result from being collected by the next calls
+            code->gc->add_ref(r.value);
+            results[i] = r.value;
+        }
+    }
+    basik_val* v = make_list(code->gc,results,n,nullptr);
+    if (!parallel) for (size_t i = 0; i < n; i++) code->gc->remove_ref(results[i]);
+    delete[] results;
+    return Result{nullptr,v};
+}
+
+Result list_filter(Code* code, BasikFunction* f, BasikList* l) {
+    size_t n = l->size;
+    bool* keep = new bool[n];
+    bool parallel = can_isolate(f,n) && items_copyable(l);
+    if (parallel) {
+        size_t chunk = chunk_size(n);
+        size_t tasks = chunk_count(n,chunk);
+        BasikException** errors = new BasikException*[tasks]();
+        parallel_call p{code,get_isolates(code),f->code,l->items(),n,chunk,nullptr,keep,errors};
+        get_pool()->run(tasks,[](void* ctx, size_t t, size_t w) {
+            parallel_call& p = *(parallel_call*)ctx;
+            Code* fn = p.isolates[w]->find(p.fn);
+            for (size_t i = t*p.chunk; i < (t+1)*p.chunk && i < p.n; i++) {
+                Result r = isolate_call(p.caller,p.isolates[w],fn,1,&p.items[i],&p.keep[i]);
+                if (r.except != nullptr) { p.errors[t] = r.except; return; }
+            }
+        },&p);
+        if (first_error(errors,tasks) != nullptr) {
+            give_up(f->code,errors,tasks,nullptr,0);
+            parallel = false;
+        }
+        delete[] errors;
+    }
+    if (!parallel) {
+        for (size_t i = 0; i < n; i++) {
+            Result r = call_function(code,f,1,&l->items()[i]);
+            if (r.except != nullptr) { delete[] keep; return r; }
+            keep[i] = code->is_val_true(r.value);
+        }
+    }
+    basik_val* v = make_list(code->gc,l->items(),n,keep);
+    delete[] keep;
+    return Result{nullptr,v};
+}
+
+/**
+ * Folds `items` from left to right, starting with `acc` (or with the first item if it is `nullptr`)
+ */
+static Result fold(Code* code, BasikFunction* f, basik_val* acc, basik_val** items, size_t n) {
+    size_t i = 0;
+    if (acc == nullptr) acc = items[i++];
+    for (; i < n; i++) {
+        basik_val* args[2] = { acc, items[i] };
+        code->gc->add_ref(acc);
+        Result r = call_function(code,f,2,args);
+        code->gc->remove_ref(acc);
+        if (r.except != nullptr) return r;
+        acc = r.value;
+    }
+    return Result{nullptr,acc};
+}
+
+Result basik_std_reduce(Code* code, size_t argc, basik_val** argv) {
+    if (argc < 2 || argc > 4) return builtin_error(code,"reduce() takes 2 to 4 arguments (%zu given)",argc);
+    if (!function_arg(argv[0])) return builtin_error(code,"reduce() expects a Function, got `%s`",type_name(argv[0]));
+    if (!list_arg(argv[1])) return builtin_error(code,"reduce() expects a List, got `%s`",type_name(argv[1]));
+    BasikFunction* f = (BasikFunction*)argv[0]->data;
+    BasikList* l = (BasikList*)argv[1]->data;
+    size_t n = l->size;
+    basik_val* init = argc > 2 ? argv[2] : nullptr;
+    if (n == 0 && init == nullptr) return builtin_error(code,"reduce() of an empty List with no initial value");
+    // Every chunk is folded on its own, then the results of the chunks are folded in order,
+    // which gives the same result as folding the whole list only when `f` is associative, so the caller has to ask for it
+    bool associative = argc > 3 && code->is_val_true(argv[3]);
+    if (!associative || !can_isolate(f,n) || !items_copyable(l)) return fold(code,f,init,l->items(),n);
+    size_t chunk = chunk_size(n);
+    size_t tasks = chunk_count(n,chunk);
+    basik_val** partial = new basik_val*[tasks]();
+    BasikException** errors = new BasikException*[tasks]();
+    parallel_call p{code,get_isolates(code),f->code,l->items(),n,chunk,partial,nullptr,errors};
+    get_pool()->run(tasks,[](void* ctx, size_t t, size_t w) {
+        parallel_call& p = *(parallel_call*)ctx;
+        Isolate* iso = p.isolates[w];
+        Code* fn = iso->find(p.fn);
+        size_t i = t*p.chunk;
+        basik_val* acc;
+        if (!isolate_copy(p.items[i],&acc)) { p.errors[t] = builtin_error(p.caller,"`%s` cannot be passed to a parallel callback",type_name(p.items[i])).except; return; }
+        for (i++; i < (t+1)*p.chunk && i < p.n; i++) {
+            basik_val* args[2] = { acc, p.items[i] };
+            Result r = isolate_call(p.caller,iso,fn,2,args,nullptr);
+            isolate_free(acc);
+            if (r.except != nullptr) { p.errors[t] = r.except; return; }
+            acc = r.value;
+        }
+        p.results[t] = acc;
+    },&p);
+    if (first_error(errors,tasks) != nullptr) {
+        give_up(f->code,errors,tasks,partial,tasks);
+        delete[] errors;
+        delete[] partial;
+        return fold(code,f,init,l->items(),n);
+    }
+    delete[] errors;
+    for (size_t t = 0; t < tasks; t++) adopt(code->gc,partial[t]);
+    Result r = fold(code,f,init,partial,tasks);
+    for (size_t t = 0; t < tasks; t++) code->gc->remove_ref(partial[t]);
+    delete[] partial;
+    return r;
+}
+
+Result list_sum(Code* code, BasikList* l) {
+    size_t n = l->size;
+    for (size_t i = 0; i < n; i++) {
+        int64_t v;
+        if (!int_value((*l)[i],&v)) return builtin_error(code,"sum() expects a List of integers, got `%s` at %zu",type_name((*l)[i]),i);
+    }
+    if (!can_split(n,PARALLEL_MIN_NATIVE)) {
+        int64_t s = 0, v;
+        for (size_t i = 0; i < n; i++) { int_value((*l)[i],&v); s += v; }
+        return Result{nullptr,val_i64(s)};
+    }
+    struct sum_call { basik_val** items; size_t n; size_t chunk; int64_t* sums; };
+    size_t chunk = chunk_size(n);
+    size_t tasks = chunk_count(n,chunk);
+    sum_call p{l->items(),n,chunk,new int64_t[tasks]};
+    get_pool()->run(tasks,[](void* ctx, size_t t, size_t w) {
+        sum_call& p = *(sum_call*)ctx;
+        int64_t s = 0, v;
+        for (size_t i = t*p.chunk; i < (t+1)*p.chunk && i < p.n; i++) { int_value(p.items[i],&v); s += v; }
+        p.sums[t] = s;
+    },&p);
+    int64_t s = 0;
+    for (size_t t = 0; t < tasks; t++) s += p.sums[t];
+    delete[] p.sums;
+    return Result{nullptr,val_i64(s)};
+}
+
+/**
+ * The order of `sort`, integers by value and strings byte by byte
+ */
+static bool sort_less(basik_val* a, basik_val* b) {
+    if (a->type == DataType::String) {
+        BasikString* sa = (BasikString*)a->data;
+        BasikString* sb = (BasikString*)b->data;
+        size_t la = sa->len-1, lb = sb->len-1;
+        int c = memcmp(sa->data,sb->data,la < lb ? la : lb);
+        return c < 0 || (c == 0 && la < lb);
+    }
+    int64_t ia, ib;
+    int_value(a,&ia);
+    int_value(b,&ib);
+    return ia < ib;
+}
+
+Result basik_std_sort(Code* code, size_t argc, basik_val** argv) {
+    if (argc != 1) return builtin_error(code,"sort() takes 1 argument (%zu given)",argc);
+    if (!list_arg(argv[0])) return builtin_error(code,"sort() expects a List, got `%s`",type_name(argv[0]));
+    BasikList* l = (BasikList*)argv[0]->data;
+    size_t n = l->size;
+    bool strings = n && (*l)[0] != nullptr && (*l)[0]->type == DataType::String;
+    for (size_t i = 0; i < n; i++) {
+        basik_val* v = (*l)[i];
+        int64_t iv;
+        if (strings ? v == nullptr || v->type != DataType::String : !int_value(v,&iv))
+            return builtin_error(code,"sort() expects a List of integers or of strings, got `%s` at %zu",type_name(v),i);
+    }
+    basik_val** items = new basik_val*[n];
+    memcpy(items,l->items(),n*sizeof(basik_val*));
+    if (!can_split(n,PARALLEL_MIN_NATIVE)) {
+        std::stable_sort(items,items+n,sort_less);
+    } else {
+        // Sorts the chunks on their own, then merges them two by two until only one is left
+        struct sort_call { basik_val** items; basik_val** tmp; size_t n; size_t chunk; };
+        size_t chunk = chunk_size(n);
+        sort_call p{items,new basik_val*[n],n,chunk};
+        get_pool()->run(chunk_count(n,chunk),[](void* ctx, size_t t, size_t w) {
+            sort_call& p = *(sort_call*)ctx;
+            std::stable_sort(p.items+t*p.chunk,p.items+std::min((t+1)*p.chunk,p.n),sort_less);
+        },&p);
+        for (; p.chunk < n; p.chunk *= 2) {
+            get_pool()->run(chunk_count(n,p.chunk*2),[](void* ctx, size_t t, size_t w) {
+                sort_call& p = *(sort_call*)ctx;
+                size_t a = t*p.chunk*2;
+                size_t m = std::min(a+p.chunk,p.n);
+                size_t b = std::min(a+p.chunk*2,p.n);
+                std::merge(p.items+a,p.items+m,p.items+m,p.items+b,p.tmp+a,sort_less);
+            },&p);
+            std::swap(p.items,p.tmp);
+        }
+        delete[] p.tmp;
+        items = p.items;
+    }
+    basik_val* v = make_list(code->gc,items,n,nullptr);
+    delete[] items;
+    return Result{nullptr,v};
+}
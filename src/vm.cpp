@@ -0,0 +1,267 @@
+#include "basik.h"
+
+/********************************\
+*            Loading             *
+\********************************/
+
+VM::VM() {
+    this->gc = new gc_t();
+    this->glob = new Globals(this->gc);
+    this->objects = new ObjectTable(this->gc,this->glob);
+    this->entry = nullptr;
+    this->glob->output = new Output(stdout,65536);
+    this->glob->input = new Input(stdin,65536);
+
+    glob->set("print",new basik_val{DataType::Function,new BasikFunction(basik_std_print)});
+    glob->set("input",new basik_val{DataType::Function,new BasikFunction(basik_std_input)});
+    glob->set("join",new basik_val{DataType::Function,new BasikFunction(basik_std_join)});
+    glob->set("flush",new basik_val{DataType::Function,new BasikFunction(basik_std_flush)});
+    glob->set("readline",new basik_val{DataType::Function,new BasikFunction(basik_std_readline)});
+    glob->set("lines",new basik_val{DataType::Function,new BasikFunction(basik_std_lines)});
+    glob->set("open",new basik_val{DataType::Function,new BasikFunction(basik_std_open)});
+    glob->set("read",new basik_val{DataType::Function,new BasikFunction(basik_std_read)});
+    glob->set("mmap_file",new basik_val{DataType::Function,new BasikFunction(basik_std_mmap_file)});
+    glob->set("split",new basik_val{DataType::Function,new BasikFunction(basik_std_split)});
+    glob->set("find",new basik_val{DataType::Function,new BasikFunction(basik_std_find)});
+    glob->set("len",new basik_val{DataType::Function,new BasikFunction(basik_std_len)});
+    glob->set("array",new basik_val{DataType::Function,new BasikFunction(basik_std_array)});
+    glob->set("sum",new basik_val{DataType::Function,new BasikFunction(basik_std_sum)});
+    glob->set("min",new basik_val{DataType::Function,new BasikFunction(basik_std_min)});
+    glob->set("max",new basik_val{DataType::Function,new BasikFunction(basik_std_max)});
+    glob->set("compare",new basik_val{DataType::Function,new BasikFunction(basik_std_compare)});
+    glob->set("filter",new basik_val{DataType::Function,new BasikFunction(basik_std_filter)});
+    glob->set("map",new basik_val{DataType::Function,new BasikFunction(basik_std_map)});
+    glob->set("reduce",new basik_val{DataType::Function,new BasikFunction(basik_std_reduce)});
+    glob->set("sort",new basik_val{DataType::Function,new BasikFunction(basik_std_sort)});
+}
+
+VM::~VM() {
+    parallel_release(this->objects);
+    delete this->glob->output;
+    delete this->glob->input;
+    delete this->objects;
+    delete this->glob;
+    delete this->gc;
+}
+
+ObjectTable::ObjectTable(gc_t* gc, Globals* glob) {
+    this->gc = gc;
+    this->glob = glob;
+    this->image = nullptr;
+    this->image_sz = 0;
+    this->symbols = nullptr;
+    this->symbols_cap = 0;
+    this->decoded = nullptr;
+    this->from = nullptr;
+}
+
+ObjectTable::ObjectTable(gc_t* gc, Globals* glob, ObjectTable* from) {
+    this->gc = gc;
+    this->glob = glob;
+    this->image = from->image;
+    this->image_sz = from->image_sz;
+    this->symbols = from->symbols;
+    this->symbols_cap = from->symbols_cap;
+    this->decoded = new CodeObj*[from->symbols_cap]();
+    this->from = from;
+}
+
+ObjectTable::~ObjectTable() {
+    for (size_t i = 0; i < this->size; i++) {
+        CodeObj* obj = this->data[i];
+        delete obj->code;
+        for (size_t t = 0; t < obj->tags.size; t++) delete[] obj->tags.data[t];
+        delete[] obj->type;
+        delete[] obj->name;
+        delete obj;
+    }
+    delete[] this->decoded;
+    // The table was built when the image was loaded, unless it is a linked one (see `load`) or this is a copy
+    if (this->from == nullptr && this->symbols != nullptr && *(uint32_t*)this->image != 0xffffffff) delete[] this->symbols;
+}
+
+bool ObjectTable::load(const uint8_t* image, size_t sz, CodeObj** entry) {
+    this->image = image;
+    this->image_sz = sz;
+    *entry = nullptr;
+    if (sz < 4) return false;
+
+    // Linked images start with a marker, then the amount of objects, the capacity of the table and the slot of the
+    // entry point, followed by the table itself and the objects, which are only decoded when they are looked up
+    if (*(uint32_t*)image == 0xffffffff) {
+        if (sz < 24) return false;
+        uint64_t cap = *(uint64_t*)(image+8);
+        uint64_t main = *(uint64_t*)(image+16);
+        if (cap == 0 || (cap & (cap-1)) != 0 || cap > (sz-24)/sizeof(symbol) || main >= cap) return false;
+        this->symbols = (const symbol*)(image+24);
+        this->symbols_cap = cap;
+        this->decoded = new CodeObj*[cap]();
+        *entry = this->decode(main);
+        return *entry != nullptr && has((*entry)->tags,"main");
+    }
+
+    // Other images are only a list of objects, the table is built by going through all of them
+    uint32_t object_count = *(uint32_t*)image;
+    // Every object takes at least 9 bytes
+    if (object_count > sz/9) return false;
+    size_t cap = 8;
+    while (cap < (size_t)object_count*2) cap *= 2;
+    symbol* table = new symbol[cap]();
+    this->symbols = table;
+    this->symbols_cap = cap;
+    this->decoded = new CodeObj*[cap]();
+    size_t off = 4;
+    for (uint32_t i = 0; i < object_count; i++) {
+        if (sz-off < 8 || *(uint64_t*)(image+off) > (uint64_t)(sz-off-8) || memchr(image+off+8,0,*(uint64_t*)(image+off)) == nullptr)
+            return false;
+        const char* name = (const char*)image+off+8;
+        uint64_t h = BasikString::hash_of(strlen(name),name);
+        size_t slot = h & (cap-1);
+        while (table[slot].offset != 0) slot = (slot+1) & (cap-1);
+        table[slot] = symbol{h,off};
+        CodeObj* obj = this->decode(slot);
+        if (obj == nullptr) return false;
+        if (has(obj->tags,"main")) *entry = obj;
+        off += 8+*(uint64_t*)(image+off);
+    }
+    return *entry != nullptr;
+}
+
+CodeObj* ObjectTable::decode(size_t slot) {
+    if (this->decoded[slot] != nullptr) return this->decoded[slot];
+
+    // The object has to fit in the image, its content is checked when it is first ran (see `pre_run`)
+    uint64_t off = this->symbols[slot].offset;
+    if (off >= this->image_sz) return nullptr;
+    uint8_t* raw_bin = (uint8_t*)this->image+off;
+    uint8_t* bin_end = (uint8_t*)this->image+this->image_sz;
+    if (bin_end-raw_bin < 8 || *(uint64_t*)raw_bin > (uint64_t)(bin_end-raw_bin-8) || memchr(raw_bin+8,0,*(uint64_t*)raw_bin) == nullptr)
+        return nullptr;
+
+    CodeObj* obj = new CodeObj();
+    uint64_t object_sz = *(uint64_t*)raw_bin;
+    const char* object_full_name = (const char*)raw_bin+8;
+    size_t object_full_name_len = strlen(object_full_name);
+    uint8_t* object_data = raw_bin+8+object_full_name_len;
+    size_t object_type_sep = -1llu;
+    for (size_t i = 0; i < object_full_name_len; i++) {
+        if (object_full_name[i] == ';') {
+            object_type_sep = i;
+            break;
+        }
+    }
+    size_t np = 0;
+    if (object_type_sep != -1llu) {
+        obj->type = new char[object_type_sep+1]();
+        memcpy((void*)obj->type,object_full_name,object_type_sep);
+        np = object_type_sep+1;
+    }
+    size_t object_tags_sep = object_full_name_len;
+    for (size_t i = np; i < object_full_name_len; i++) {
+        if (object_full_name[i] == '/') {
+            object_tags_sep = i;
+            break;
+        }
+    }
+    obj->name = new char[object_tags_sep+1]();
+    memcpy((void*)obj->name,object_full_name+np,object_tags_sep-np);
+    // The tags follow the name, each of them after a `/`
+    for (size_t t = object_tags_sep; t < object_full_name_len; ) {
+        size_t e = t+1;
+        while (e < object_full_name_len && object_full_name[e] != '/') e++;
+        if (e > t+1) {
+            char* tag = new char[e-t]();
+            memcpy(tag,object_full_name+t+1,e-t-1);
+            obj->tags.push(tag);
+        }
+        t = e;
+    }
+    obj->full_name = object_full_name;
+    obj->data = object_data+1;
+    obj->data_sz = object_sz-object_full_name_len-1;
+    obj->code = new Code(this->gc,this->glob,(const char*)obj->data,obj->data_sz,this);
+    obj->code->obj = obj;
+
+    // The copies of isolates run the same ahead-of-time compiled code, and do not import again what the program already did
+    if (this->from != nullptr && this->from->decoded[slot] != nullptr) {
+        obj->code->native = this->from->decoded[slot]->code->native;
+        obj->imported = this->from->decoded[slot]->imported;
+    }
+
+    this->decoded[slot] = obj;
+    this->push(obj);
+    return obj;
+}
+
+CodeObj* ObjectTable::find(const char* name) {
+    if (this->symbols_cap == 0) return nullptr;
+    uint64_t h = BasikString::hash_of(strlen(name),name);
+    size_t slot = h & (this->symbols_cap-1);
+    for (size_t i = 0; i < this->symbols_cap && this->symbols[slot].offset != 0; i++, slot = (slot+1) & (this->symbols_cap-1)) {
+        if (this->symbols[slot].hash != h) continue;
+        CodeObj* obj = this->decode(slot);
+        if (obj != nullptr && !strcmp(obj->full_name,name)) return obj;
+    }
+    return nullptr;
+}
+
+bool ObjectTable::load_all() {
+    for (size_t slot = 0; slot < this->symbols_cap; slot++)
+        if (this->symbols[slot].offset != 0 && this->decode(slot) == nullptr) return false;
+    return true;
+}
+
+bool VM::load(const uint8_t* image, size_t sz) {
+    CodeObj* entry;
+    if (!this->objects->load(image,sz,&entry)) return false;
+    this->entry = entry->code;
+    return true;
+}
+
+void VM::define(const char* name, Result(*callback)(Code*,size_t,basik_val**)) {
+    this->glob->host_functions = true;
+    this->glob->set(name,new basik_val{DataType::Function,new BasikFunction(callback)});
+}
+
+/********************************\
+*            Running             *
+\********************************/
+
+Result VM::run() {
+    // The program counts as imported, so that it is never ran again by one of its modules
+    this->entry->obj->imported = true;
+    Result res = pre_run(this->entry);
+    if (res.except != nullptr) return res;
+    return call_code(this->entry);
+}
+
+Result VM::call(const char* name, size_t argc, basik_val** argv) {
+    basik_val* fn = this->glob->get(name);
+    if (fn == nullptr || fn->type != DataType::Function)
+        return Result{new BasikException(0,nullptr,"`%s` is not a function",name),nullptr};
+    BasikFunction* f = (BasikFunction*)fn->data;
+    if (f->callback) return f->callback(this->entry,argc,argv);
+    BasikList* args = new BasikList();
+    for (size_t i = 0; i < argc; i++) {
+        this->gc->add_ref(argv[i]);
+        args->append(argv[i]);
+    }
+    return call_code_with(f->code,new basik_val{DataType::List,args});
+}
+
+void print_exception(FILE* f, BasikException* e) {
+    fprintf(f,"ERROR: Runtime exception:\n");
+    for (size_t i = 0; i < e->traci; i++) {
+        size_t j = e->traci-i-1;
+        Code* c = e->frames[j].code;
+        // The errors of the host API itself do not come from an object
+        if (c == nullptr) continue;
+        size_t addr = e->frames[j].addr-1;
+        const char* source = c->get_source();
+        if (source != nullptr)
+            fprintf(f,"  in %s (%s:%u, at %zu):\n",c->obj->full_name,source,c->get_line(addr),addr);
+        else
+            fprintf(f,"  in %s (at %zu):\n",c->obj->full_name,addr);
+    }
+    fprintf(f,"    : %s\n",e->text);
+}
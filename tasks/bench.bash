@@ -0,0 +1,12 @@
+#!/usr/bin/env bash
+
+excode=0
+
+mkdir ./tests/tmp
+
+python3 tests/bench.py "$@"
+excode=$?
+
+rm -rf ./tests/tmp/
+
+exit $excode
@@ -3,23 +3,36 @@
 TGT="$OSTYPE"
 
 C_WARNINGS="-Wall -Wextra -Wno-unused-variable -Wno-unused-parameter -Wno-format-security -Werror"
-C_INPUT="./src/*.cpp"
+C_INPUT="./src/main.cpp"
+C_INPUT_LIB="$(ls ./src/*.cpp | grep -v '/main.cpp$')"
 C_INCLUDE="-I ./ -I ./src/"
 C_EXTRA=""
+C_SHARED=""
 
 C_OUTPUT_WIN="./out/basik.exe"
 C_OUTPUT_LINUX="./out/basik"
+C_OUTPUT_LIB="./out/libbasik.a"
+C_OUTPUT_SHARED="./out/libbasik.so"
+C_OUTPUT_OBJ="./out/obj"
 
 C_LIB_WIN=""
 C_LIB_LINUX=""
 
 B_SUCCESS="\e[32mSUCCESS\e[39m: Built Basik"
 B_ERROR_COMPILE="\e[31mERROR\e[39m: Could not build Basik"
+B_ERROR_COMPILE_LIB="\e[31mERROR\e[39m: Could not build libbasik"
 
 ignorearg=""
 for arg in "$@"; do
     if [[ $ignorearg == "target" ]] ; then
         TGT=$arg
+        ignorearg=""
+    elif [[ $ignorearg == "aot" ]] ; then
+        # Builds a program compiled by `basik --aot` instead of the CLI
+        C_INPUT="$arg"
+        C_OUTPUT_WIN="./out/$(basename ${arg%.cpp}).exe"
+        C_OUTPUT_LINUX="./out/$(basename ${arg%.cpp})"
+        ignorearg=""
     else
         if [[ $arg == "-O3" ]]; then
             C_EXTRA="$C_EXTRA -O3"
@@ -33,8 +46,15 @@ for arg in "$@"; do
             C_EXTRA="$C_EXTRA -O0"
         elif [[ $arg == "-target" ]] ; then
             ignorearg="target"
+        elif [[ $arg == "-aot" ]] ; then
+            ignorearg="aot"
         elif [[ $arg == "-g" ]] ; then
             C_EXTRA="$C_EXTRA -g"
+        elif [[ $arg == "-perf" ]] ; then
+            C_EXTRA="$C_EXTRA -fno-omit-frame-pointer"
+        elif [[ $arg == "-shared" ]] ; then
+            C_SHARED="1"
+            C_EXTRA="$C_EXTRA -fPIC"
         fi
     fi
 done
@@ -44,11 +64,34 @@ function runcmd {
     return $($1)
 }
 
+# Builds everything but the CLI entry point into a static library, so that other programs (benchmarks...) can link against the VM
+function buildlib {
+    mkdir -p $C_OUTPUT_OBJ
+    rm -f $C_OUTPUT_OBJ/*.o $C_OUTPUT_LIB
+    for src in $C_INPUT_LIB; do
+        if ! runcmd "g++ -c $src $C_WARNINGS -o $C_OUTPUT_OBJ/$(basename ${src%.cpp}).o $C_INCLUDE $C_EXTRA" ; then
+            return 1
+        fi
+    done
+    if ! runcmd "ar rcs $C_OUTPUT_LIB $(ls $C_OUTPUT_OBJ/*.o | tr '\n' ' ')" ; then
+        return 1
+    fi
+    # With `-shared`, for programs that load the VM at runtime
+    if [[ $C_SHARED == "1" ]] ; then
+        runcmd "g++ -shared -o $C_OUTPUT_SHARED $(ls $C_OUTPUT_OBJ/*.o | tr '\n' ' ') $C_EXTRA -pthread"
+    fi
+}
+
 if [[ "$TGT" == "msys" ]] ; then
 
     mkdir -p $(dirname $C_OUTPUT_WIN)
 
-    win_cmd0="g++ $C_INPUT $C_WARNINGS -o $C_OUTPUT_WIN $C_INCLUDE $C_EXTRA $C_LIB_WIN"
+    if ! buildlib ; then
+        echo -e "\n$B_ERROR_COMPILE_LIB"
+        exit 1
+    fi
+
+    win_cmd0="g++ $C_INPUT $C_OUTPUT_LIB $C_WARNINGS -o $C_OUTPUT_WIN $C_INCLUDE $C_EXTRA $C_LIB_WIN"
 
     if ! runcmd "$win_cmd0" ; then
         echo -e "\n$B_ERROR_COMPILE"
@@ -62,7 +105,12 @@ elif [[ "$TGT" == "linux-gnu" ]] ; then
 
     mkdir -p $(dirname $C_OUTPUT_LINUX)
 
-    linux_cmd0="g++ $C_INPUT $C_WARNINGS -o $C_OUTPUT_LINUX $C_INCLUDE $C_EXTRA -Wl,--copy-dt-needed-entries $C_LIB_LINUX"
+    if ! buildlib ; then
+        echo -e "\n$B_ERROR_COMPILE_LIB"
+        exit 1
+    fi
+
+    linux_cmd0="g++ $C_INPUT $C_OUTPUT_LIB $C_WARNINGS -o $C_OUTPUT_LINUX $C_INCLUDE $C_EXTRA -Wl,--copy-dt-needed-entries $C_LIB_LINUX"
 
     if ! runcmd "$linux_cmd0" ; then
         echo -e "\n$B_ERROR_COMPILE"
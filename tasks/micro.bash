@@ -0,0 +1,57 @@
+#!/usr/bin/env bash
+
+# Builds libbasik and the microbenchmarks of ./tests/micro/, and runs them
+# Usage: ./tasks/micro.bash [build flags...] [-- benchmark names...]
+
+C_WARNINGS="-Wall -Wextra -Wno-unused-variable -Wno-unused-parameter -Wno-format-security -Werror"
+C_INCLUDE="-I ./ -I ./src/ -I ./tests/micro/"
+C_OUTPUT="./out/micro"
+
+build_args=()
+names=()
+ignorearg="build"
+for arg in "$@"; do
+    if [[ $arg == "--" ]] ; then
+        ignorearg="names"
+    elif [[ $ignorearg == "names" ]] ; then
+        names+=("$arg")
+    else
+        build_args+=("$arg")
+    fi
+done
+
+# Benchmarks are meaningless without optimizations
+if [[ ${#build_args[@]} == 0 ]] ; then
+    build_args=("-O2")
+fi
+
+if ! bash ./tasks/build.bash "${build_args[@]}" > /dev/null ; then
+    echo -e "\e[31mERROR\e[39m: Could not build Basik"
+    exit 1
+fi
+
+C_EXTRA=""
+for arg in "${build_args[@]}"; do
+    if [[ $arg =~ ^-O[0-3]$ || $arg == "-g" ]] ; then
+        C_EXTRA="$C_EXTRA $arg"
+    fi
+done
+
+mkdir -p $C_OUTPUT
+
+excode=0
+
+for src in ./tests/micro/*.cpp; do
+    bin="$C_OUTPUT/$(basename ${src%.cpp})"
+    if ! g++ $src ./out/libbasik.a $C_WARNINGS -o $bin $C_INCLUDE $C_EXTRA ; then
+        echo -e "\e[31mERROR\e[39m: Could not build $src"
+        excode=1
+        continue
+    fi
+    echo -e "\e[36m----- $(basename ${src%.cpp}) -----\e[39m"
+    if ! $bin "${names[@]}" ; then
+        excode=1
+    fi
+done
+
+exit $excode
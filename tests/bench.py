@@ -0,0 +1,129 @@
+import os
+import json
+import shlex
+import argparse
+import statistics
+import subprocess
+import threading
+import time
+
+print('----- Benchmarks -----')
+
+parser = argparse.ArgumentParser(description='Runs the benchmarks of ./tests/bench/ and compares them against the stored baseline')
+parser.add_argument('-n','--runs',type=int,default=5,help='amount of runs per benchmark (default: 5)')
+parser.add_argument('-t','--tolerance',type=float,default=0.3,help='allowed slowdown/growth relative to the baseline (default: 0.3)')
+parser.add_argument('--timeout',type=float,default=20,help='maximum duration of a single run, in seconds (default: 20)')
+parser.add_argument('--update',action='store_true',help='stores the results as the new baseline')
+parser.add_argument('cases',nargs='*',help='only runs the benchmarks whose name contains one of these')
+args = parser.parse_args()
+
+bench_dir = './tests/bench/'
+baseline_file = os.path.join(bench_dir,'baseline.json')
+
+cases: list[str] = sorted(fn[:-3] for fn in os.listdir(bench_dir) if fn.endswith('.py') and (not args.cases or any(c in fn for c in args.cases)))
+
+baseline: dict[str,dict] = {}
+if os.path.exists(baseline_file):
+    with open(baseline_file,'r') as file:
+        baseline = json.load(file)
+
+def run(bsk_file:str) -> tuple[int,float,dict[str,int],int]:
+    """
+    Runs a program once, giving back its exit status, its duration, the stats reported by the VM and its peak RSS (in KB)
+    """
+    start = time.perf_counter()
+    p = subprocess.Popen(['./out/basik','--stats',bsk_file],stdout=subprocess.DEVNULL,stderr=subprocess.PIPE,universal_newlines=True,errors='ignore')
+    timer = threading.Timer(args.timeout,p.kill)
+    timer.start()
+    stderr = p.stderr.read()
+    _, status, rusage = os.wait4(p.pid,0)
+    duration = time.perf_counter()-start
+    timer.cancel()
+    p.stderr.close()
+    p.returncode = os.waitstatus_to_exitcode(status)
+    stats = {}
+    for line in stderr.splitlines():
+        k, _, v = line.partition(': ')
+        if k in ('instructions','allocations') and v.isdigit():
+            stats[k] = int(v)
+    return p.returncode, duration, stats, rusage.ru_maxrss
+
+def compare(name:str, value:float, base:float) -> tuple[str,bool]:
+    """
+    Compares a value against the baseline, giving back a description of the change and whether it is a regression
+    """
+    if not base: return '', False
+    d = (value-base)/base
+    bad = d > args.tolerance
+    return ' %s %s%+.1f%%\x1b[39m' % (name,'\x1b[31m' if bad else '\x1b[32m' if d < -args.tolerance else '\x1b[90m',d*100), bad
+
+results: dict[str,dict] = {}
+fails: set[str] = set()
+regs: set[str] = set()
+w = max(map(len,cases),default=0)
+
+for case in cases:
+    print('[BENCH] %s' % (case,)+' '*(w-len(case)),end='',flush=True)
+    bsk_file = os.path.join('./tests/tmp/','bench-'+case+'.bsk')
+    p = subprocess.Popen('python3 compiler.py %s %s'%(shlex.quote(os.path.join(bench_dir,case+'.py')),shlex.quote(bsk_file)),shell=True,universal_newlines=True,stdout=subprocess.DEVNULL,stderr=subprocess.PIPE)
+    _, stderr = p.communicate()
+    if p.returncode != 0:
+        fails.add(case)
+        print(' \x1b[31m[FAILED]\x1b[39m \x1b[90m(compilation error)\x1b[39m')
+        continue
+    durations = []
+    rss = 0
+    stats = {}
+    for _ in range(args.runs):
+        code, duration, stats, peak = run(bsk_file)
+        if code != 0: break
+        durations.append(duration)
+        rss = max(rss,peak)
+    os.remove(bsk_file)
+    if code != 0:
+        fails.add(case)
+        print(' \x1b[31m[FAILED]\x1b[39m \x1b[90m(%s)\x1b[39m' % ('timed out' if code == -9 else 'exit code %d' % code,))
+        continue
+    median = statistics.median(durations)
+    instructions = stats.get('instructions',0)
+    allocations = stats.get('allocations',0)
+    results[case] = {
+        'median': round(median,6),
+        'instructions': instructions,
+        'allocations': allocations,
+        'rss': rss,
+    }
+    line = ' %9.2f ms %8.2f M instr/s %8.2f MB rss %10d allocs' % (median*1000,instructions/median/1e6,rss/1024,allocations)
+    base = baseline.get(case)
+    if base is None:
+        print(line+' \x1b[90m[NEW]\x1b[39m')
+        continue
+    diffs = [
+        compare('time',median,base.get('median')),
+        compare('instrs',instructions,base.get('instructions')),
+        compare('allocs',allocations,base.get('allocations')),
+        compare('rss',rss,base.get('rss')),
+    ]
+    if any(bad for _, bad in diffs):
+        regs.add(case)
+        print(line+' \x1b[31m[REGRESSION]\x1b[39m')
+    else:
+        print(line+' \x1b[32m[OK]\x1b[39m')
+    print('      \x1b[90m(vs baseline:%s\x1b[90m)\x1b[39m' % (''.join(d for d, _ in diffs),))
+
+print()
+
+if args.update:
+    baseline.update(results)
+    with open(baseline_file,'w') as file:
+        json.dump(baseline,file,indent=4,sort_keys=True)
+        file.write('\n')
+    print('Baseline updated with %d benchmark%s (%s)' % (len(results),'s' if len(results)!=1 else '',baseline_file))
+
+ec_bas = sum(c in baseline for c in fails) # Failures of benchmarks that have a baseline
+print('Benchmarks:  \x1b[%dm%d\x1b[39m' % (32 if results else 90,len(results)))
+print('Failures:    \x1b[%dm%d\x1b[39m' % (31 if fails else 90,len(fails)))
+print('Regressions: \x1b[%dm%d\x1b[39m' % (31 if regs else 90,len(regs)))
+
+# Benchmarks that are not part of the baseline yet (e.g. that do not run yet) are reported but do not fail the run
+if (regs or ec_bas) and not args.update: exit(1)
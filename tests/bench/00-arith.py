@@ -0,0 +1,6 @@
+n = 20000
+acc = 0
+while n:
+    acc = acc + n * 3 - n / 2
+    n = n - 1
+print(acc)
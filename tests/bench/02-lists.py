@@ -0,0 +1,6 @@
+n = 1000
+l = []
+while n:
+    l = [n, n - 1, l]
+    n = n - 1
+print(l == l)
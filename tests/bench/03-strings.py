@@ -0,0 +1,9 @@
+n = 10000
+hits = 0
+while n:
+    if 'the quick brown fox jumps over the lazy dog' == 'the quick brown fox jumps over the lazy dog':
+        hits = hits + 1
+    if 'the quick brown fox jumps over the lazy dog' == 'the quick brown fox jumps over the lazy cat':
+        hits = hits - 1
+    n = n - 1
+print(hits)
@@ -0,0 +1,13 @@
+global a, b, c, d, n
+a = 0
+b = 0
+c = 0
+d = 0
+n = 10000
+while n:
+    a = a + 1
+    b = b + a
+    c = c + b - a
+    d = a + b + c + d - c
+    n = n - 1
+print(a, b, c, d)
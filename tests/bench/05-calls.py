@@ -0,0 +1,12 @@
+def add(a, b):
+    return a + b
+
+def step(x):
+    return add(x, 1)
+
+n = 1000
+x = 0
+while n:
+    x = step(x)
+    n = n - 1
+print(x)
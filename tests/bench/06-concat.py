@@ -0,0 +1,6 @@
+n = 20000
+report = ''
+while n:
+    report = report + 'line of the report\n'
+    n = n - 1
+print(report == report + '')
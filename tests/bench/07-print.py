@@ -0,0 +1,4 @@
+n = 5000
+while n:
+    print('line', n, 'of the output')
+    n = n - 1
@@ -0,0 +1,7 @@
+counts = {'the': 0, 'quick': 0, 'fox': 0}
+n = 5000
+while n:
+    counts['the'] = counts['the'] + 1
+    counts['fox'] = counts['fox'] + 2
+    n = n - 1
+print(counts['the'], counts['fox'])
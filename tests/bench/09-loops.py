@@ -0,0 +1,5 @@
+acc = 0
+for n in range(20000, 0, -1):
+    if n < 10000:
+        acc = acc + n * 3 - n / 2
+print(acc)
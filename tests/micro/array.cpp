@@ -0,0 +1,65 @@
+#include "micro.h"
+
+static BasikArray* a = nullptr;
+static BasikArray* b = nullptr;
+static BasikList* list = nullptr;
+
+/**
+ * Creates two arrays and a List holding the same `n` values, the List is what a program
+ * would have to loop over without arrays
+ */
+static void fill(size_t n) {
+    a = new BasikArray(DataType::I64,n);
+    b = new BasikArray(DataType::I64,n);
+    list = new BasikList();
+    for (size_t i = 0; i < n; i++) {
+        a->set(i,(int64_t)(i*7919%1000));
+        b->set(i,(int64_t)i);
+        list->append(new basik_val{DataType::I64,new BasikI64((int64_t)(i*7919%1000))});
+    }
+}
+
+static void destroy(size_t n) {
+    for (size_t i = 0; i < n; i++) delete (*list)[i];
+    delete list;
+    delete a;
+    delete b;
+}
+
+int main(int argc, const char** argv) {
+
+    printf("array kernels: %s\n",array_isa());
+
+    for (size_t n : micro_sizes) {
+        if (micro_selected(argc,argv,"array.sum"))
+            micro_run("array.sum",n,n,fill,[](size_t n) {
+                micro_keep((void*)array_sum(a));
+            },destroy);
+        if (micro_selected(argc,argv,"list.sum"))
+            micro_run("list.sum",n,n,fill,[](size_t n) {
+                // Boxes every partial sum the way the Add instruction does
+                basik_val* s = new basik_val{DataType::I64,new BasikI64(0)};
+                for (size_t i = 0; i < n; i++) {
+                    basik_val* r = new basik_val{DataType::I64,new BasikI64(*((BasikI64*)s->data)->data+*((BasikI64*)(*list)[i]->data)->data)};
+                    delete s;
+                    s = r;
+                }
+                micro_keep(s);
+                delete s;
+            },destroy);
+        if (micro_selected(argc,argv,"array.add"))
+            micro_run("array.add",n,n,fill,[](size_t n) {
+                BasikArray* r = array_binop('+',a,b);
+                micro_keep(r);
+                delete r;
+            },destroy);
+        if (micro_selected(argc,argv,"array.filter"))
+            micro_run("array.filter",n,n,fill,[](size_t n) {
+                BasikArray* r = array_filter(a,CmpLt,500);
+                micro_keep(r);
+                delete r;
+            },destroy);
+    }
+
+    return 0;
+}
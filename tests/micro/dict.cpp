@@ -0,0 +1,57 @@
+#include "micro.h"
+
+// The amount of lookups timed per run
+const size_t ops = 1024;
+
+static gc_t* gc = nullptr;
+static BasikDict* dict = nullptr;
+static basik_val** keys = nullptr;
+static basik_val* missing = nullptr;
+
+/**
+ * Creates a dict of `n` string keys named `k<i>`, the keys looked up are separate copies
+ * of them so that the lookups have to compare the contents of the strings
+ */
+static void fill(size_t n) {
+    gc = new gc_t();
+    dict = new BasikDict(gc,0);
+    keys = new basik_val*[n];
+    for (size_t i = 0; i < n; i++) {
+        char name[24];
+        snprintf(name,sizeof(name),"k%zu",i);
+        dict->set(new basik_val{DataType::String,new BasikString(strlen(name)+1,name)},new basik_val{DataType::I64,new BasikI64(i)});
+        keys[i] = new basik_val{DataType::String,new BasikString(strlen(name)+1,name)};
+    }
+    missing = new basik_val{DataType::String,new BasikString(strlen("missing")+1,"missing")};
+}
+
+static void destroy(size_t n) {
+    for (size_t i = 0; i < n; i++) delete keys[i];
+    delete[] keys;
+    delete missing;
+    delete dict;
+    delete gc;
+}
+
+int main(int argc, const char** argv) {
+
+    for (size_t n : micro_sizes) {
+        if (micro_selected(argc,argv,"dict.get.spread"))
+            micro_run("dict.get.spread",n,ops,fill,[](size_t n) {
+                for (size_t i = 0; i < ops; i++) micro_keep(dict->find(keys[(i*7919)%n]));
+            },destroy);
+        if (micro_selected(argc,argv,"dict.get.missing"))
+            micro_run("dict.get.missing",n,ops,fill,[](size_t n) {
+                for (size_t i = 0; i < ops; i++) micro_keep(dict->find(missing));
+            },destroy);
+        if (micro_selected(argc,argv,"dict.set.known"))
+            micro_run("dict.set.known",n,ops,fill,[](size_t n) {
+                for (size_t i = 0; i < ops; i++) {
+                    basik_val* k = keys[(i*7919)%n];
+                    dict->set(k,dict->find(k)->value);
+                }
+            },destroy);
+    }
+
+    return 0;
+}
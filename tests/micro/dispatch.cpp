@@ -0,0 +1,90 @@
+#include "micro.h"
+
+// The amount of times the measured instruction sequence is repeated
+const size_t reps = 1024;
+
+static gc_t* gc = nullptr;
+static Globals* glob = nullptr;
+static Code* code = nullptr;
+static Buffer* bytecode = nullptr;
+// The benchmarked code does not refer to other objects
+static ObjectTable* objects;
+static size_t instrs = 0;
+
+/**
+ * Assembles an object that runs `seq` (`seq_sz` bytes, `seq_instrs` instructions) `reps` times
+ * `jump` is the offset of an address to patch inside of the sequence, so that it points to the next one
+ */
+static void assemble(const uint8_t* seq, size_t seq_sz, size_t seq_instrs, size_t jump = -1llu) {
+    const size_t header = 16;
+    bytecode = new Buffer(header+seq_sz*reps+3);
+    memset(bytecode->data,0,header);
+    // No constant nor variable, a stack of 2 values (for `add`) and no line table
+    *(uint32_t*)(bytecode->data+8) = 2;
+    for (size_t i = 0; i < reps; i++) {
+        uint8_t* p = bytecode->data+header+i*seq_sz;
+        memcpy(p,seq,seq_sz);
+        if (jump != -1llu) *(uint64_t*)(p+jump) = (i+1)*seq_sz;
+    }
+    uint8_t* end = bytecode->data+header+seq_sz*reps;
+    end[0] = OpCodes::PushNull;
+    end[1] = OpCodes::Return;
+    end[2] = OpCodes::End;
+    instrs = seq_instrs*reps+2;
+}
+
+/**
+ * Creates a VM with `n` live values in the GC
+ */
+static void vm(size_t n) {
+    gc = new gc_t();
+    glob = new Globals(gc);
+    objects = new ObjectTable(gc,glob);
+    for (size_t i = 0; i < n; i++) gc->add_ref(new basik_val{DataType::Bool,new BasikBool(true)});
+    code = new Code(gc,glob,(const char*)bytecode->data,bytecode->size,objects);
+    Result r = pre_run(code);
+    if (r.except != nullptr) {
+        fprintf(stderr,"%s\n",r.except->text);
+        exit(1);
+    }
+}
+
+static void run_code(size_t n) {
+    Result r = run(code);
+    if (r.except != nullptr) {
+        fprintf(stderr,"%s\n",r.except->text);
+        exit(1);
+    }
+}
+
+static void destroy(size_t n) {
+    delete code;
+    delete glob;
+    delete gc;
+}
+
+static void bench(int argc, const char** argv, const char* name, const uint8_t* seq, size_t seq_sz, size_t seq_instrs, size_t jump = -1llu) {
+    if (!micro_selected(argc,argv,name)) return;
+    assemble(seq,seq_sz,seq_instrs,jump);
+    for (size_t n : micro_sizes) micro_run(name,n,instrs,vm,run_code,destroy);
+    delete bytecode;
+}
+
+int main(int argc, const char** argv) {
+
+    // `n` is the amount of live values in the GC while the instructions are executed
+
+    const uint8_t push_null[] = { OpCodes::PushNull, OpCodes::Pop };
+    bench(argc,argv,"dispatch.push_null",push_null,sizeof(push_null),2);
+
+    const uint8_t push_i64[] = { OpCodes::PushI64, 1,0,0,0,0,0,0,0, OpCodes::Pop };
+    bench(argc,argv,"dispatch.push_i64",push_i64,sizeof(push_i64),2);
+
+    const uint8_t jump[] = { OpCodes::Jump, 0,0,0,0,0,0,0,0 };
+    bench(argc,argv,"dispatch.jump",jump,sizeof(jump),1,1);
+
+    const uint8_t add[] = { OpCodes::PushI64, 1,0,0,0,0,0,0,0, OpCodes::PushI64, 2,0,0,0,0,0,0,0, OpCodes::Add, OpCodes::Pop };
+    bench(argc,argv,"dispatch.add_i64",add,sizeof(add),4);
+
+    return 0;
+}
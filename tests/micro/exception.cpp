@@ -0,0 +1,52 @@
+#include "micro.h"
+
+/**
+ * A call chain of `depth` frames that either fails at the bottom or returns a value,
+ * each frame adds itself to the trace the way `call_code` does
+ */
+__attribute__((noinline)) static Result call(size_t depth, bool fail, bool format) {
+    if (depth == 0) {
+        if (!fail) return Result{nullptr,nullptr};
+        if (format) return Result{new BasikException(depth,nullptr,"len() does not support `%s`","I64"),nullptr};
+        return Result{new BasikException("Stack underflow",depth,nullptr),nullptr};
+    }
+    Result r = call(depth-1,fail,format);
+    if (r.except != nullptr) r.except->add_trace(depth,nullptr);
+    micro_keep(r);
+    return r;
+}
+
+int main(int argc, const char** argv) {
+
+    for (size_t n : micro_sizes) {
+        if (micro_selected(argc,argv,"exception.return"))
+            micro_run("exception.return",n,n,[](size_t n) {
+                for (size_t i = 0; i < n; i++) micro_keep(call(4,false,false));
+            });
+        if (micro_selected(argc,argv,"exception.raise"))
+            micro_run("exception.raise",n,n,[](size_t n) {
+                for (size_t i = 0; i < n; i++) {
+                    Result r = call(4,true,false);
+                    micro_keep(r.except->text);
+                    delete r.except;
+                }
+            });
+        if (micro_selected(argc,argv,"exception.format"))
+            micro_run("exception.format",n,n,[](size_t n) {
+                for (size_t i = 0; i < n; i++) {
+                    Result r = call(4,true,true);
+                    micro_keep(r.except->text);
+                    delete r.except;
+                }
+            });
+        // Outgrows the inline frames
+        if (micro_selected(argc,argv,"exception.deep"))
+            micro_run("exception.deep",n,n,[](size_t n) {
+                Result r = call(n,true,false);
+                micro_keep(r.except->frames);
+                delete r.except;
+            });
+    }
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "micro.h"
+
+// The amount of operations timed per run of the benchmarks that do not depend on the size
+const size_t ops = 1024;
+
+static gc_t* gc = nullptr;
+static basik_val** vals = nullptr;
+
+/**
+ * Creates a GC holding `n` live values
+ */
+static void heap(size_t n) {
+    gc = new gc_t();
+    vals = new basik_val*[n+ops];
+    for (size_t i = 0; i < n+ops; i++) vals[i] = new basik_val{DataType::Bool,new BasikBool(true)};
+    for (size_t i = 0; i < n; i++) gc->add_ref(vals[i]);
+}
+
+/**
+ * Frees the GC and all its values
+ */
+static void free_heap(size_t n) {
+    for (size_t i = 0; i < gc->refs->size; i++) {
+        gc->refs->data[i].c = 1;
+        gc->remove_ref(gc->refs->data[i].v);
+    }
+    gc->collect();
+    delete gc;
+    delete[] vals;
+}
+
+int main(int argc, const char** argv) {
+
+    for (size_t n : micro_sizes) {
+        // Adding a reference to a value that is already known, the last one is the worst case
+        if (micro_selected(argc,argv,"gc.add_ref.known"))
+            micro_run("gc.add_ref.known",n,ops,heap,[](size_t n) {
+                for (size_t i = 0; i < ops; i++) gc->add_ref(vals[n-1-i%n]);
+            },free_heap);
+        // Adding the first reference to a value
+        if (micro_selected(argc,argv,"gc.add_ref.new"))
+            micro_run("gc.add_ref.new",n,ops,heap,[](size_t n) {
+                for (size_t i = 0; i < ops; i++) gc->add_ref(vals[n+i]);
+            },free_heap);
+        if (micro_selected(argc,argv,"gc.remove_ref"))
+            micro_run("gc.remove_ref",n,ops,heap,[](size_t n) {
+                for (size_t i = 0; i < ops; i++) gc->remove_ref(vals[n-1-i%n]);
+            },free_heap);
+        // Collecting when everything is still alive, which is what happens after most instructions
+        if (micro_selected(argc,argv,"gc.collect.live"))
+            micro_run("gc.collect.live",n,1,heap,[](size_t n) {
+                micro_keep(gc->collect());
+            },free_heap);
+        // Collecting when everything is dead, per freed value
+        if (micro_selected(argc,argv,"gc.collect.dead"))
+            micro_run("gc.collect.dead",n,n,[](size_t n) {
+                heap(n);
+                for (size_t i = 0; i < n; i++) gc->remove_ref(vals[i]);
+            },[](size_t n) {
+                micro_keep(gc->collect());
+            },free_heap);
+    }
+
+    return 0;
+}
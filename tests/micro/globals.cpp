@@ -0,0 +1,56 @@
+#include "micro.h"
+
+// The amount of lookups timed per run
+const size_t ops = 1024;
+
+static gc_t* gc = nullptr;
+static Globals* glob = nullptr;
+static char** names = nullptr;
+
+/**
+ * Creates `n` globals named `g<i>`
+ */
+static void fill(size_t n) {
+    gc = new gc_t();
+    glob = new Globals(gc);
+    names = new char*[n];
+    for (size_t i = 0; i < n; i++) {
+        names[i] = new char[24];
+        snprintf(names[i],24,"g%zu",i);
+        glob->set(names[i],new basik_val{DataType::Bool,new BasikBool(true)});
+    }
+}
+
+static void destroy(size_t n) {
+    for (size_t i = 0; i < n; i++) delete[] names[i];
+    delete[] names;
+    delete glob;
+    delete gc;
+}
+
+int main(int argc, const char** argv) {
+
+    for (size_t n : micro_sizes) {
+        // The most recently defined name, which is the worst case of a linear scan
+        if (micro_selected(argc,argv,"globals.get.last"))
+            micro_run("globals.get.last",n,ops,fill,[](size_t n) {
+                for (size_t i = 0; i < ops; i++) micro_keep(glob->get(names[n-1]));
+            },destroy);
+        // Names spread over the whole table
+        if (micro_selected(argc,argv,"globals.get.spread"))
+            micro_run("globals.get.spread",n,ops,fill,[](size_t n) {
+                for (size_t i = 0; i < ops; i++) micro_keep(glob->get(names[(i*7919)%n]));
+            },destroy);
+        // A name that is not defined
+        if (micro_selected(argc,argv,"globals.get.missing"))
+            micro_run("globals.get.missing",n,ops,fill,[](size_t n) {
+                for (size_t i = 0; i < ops; i++) micro_keep(glob->get("missing"));
+            },destroy);
+        if (micro_selected(argc,argv,"globals.set.known"))
+            micro_run("globals.set.known",n,ops,fill,[](size_t n) {
+                for (size_t i = 0; i < ops; i++) glob->set(names[n-1],glob->get(names[n-1]));
+            },destroy);
+    }
+
+    return 0;
+}
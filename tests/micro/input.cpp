@@ -0,0 +1,44 @@
+#include "micro.h"
+
+static FILE* file = nullptr;
+
+/**
+ * Writes `n` lines to a temporary file
+ */
+static void fill(size_t n) {
+    file = tmpfile();
+    for (size_t i = 0; i < n; i++) fprintf(file,"line %zu of the input\n",i);
+    rewind(file);
+}
+
+static void destroy(size_t n) {
+    fclose(file);
+}
+
+int main(int argc, const char** argv) {
+
+    for (size_t n : micro_sizes) {
+        // What `input` used to do: a 64 KiB scratch buffer and a copy for every line
+        if (micro_selected(argc,argv,"input.scanf"))
+            micro_run("input.scanf",n,n,fill,[](size_t n) {
+                for (size_t i = 0; i < n; i++) {
+                    char* value = new char[65536];
+                    if (fscanf(file,"%s",value) != 1) break;
+                    BasikString* s = new BasikString(strlen(value)+1,value);
+                    delete[] value;
+                    micro_keep(s->data);
+                    delete s;
+                }
+            },destroy);
+        if (micro_selected(argc,argv,"input.readline"))
+            micro_run("input.readline",n,n,fill,[](size_t n) {
+                Input in(file,65536);
+                for (BasikString* s; (s = in.readline()) != nullptr;) {
+                    micro_keep(s->data);
+                    delete s;
+                }
+            },destroy);
+    }
+
+    return 0;
+}
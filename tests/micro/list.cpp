@@ -0,0 +1,46 @@
+#include "micro.h"
+
+// The amount of slices taken per run
+const size_t ops = 256;
+
+static gc_t* gc = nullptr;
+static BasikList* list = nullptr;
+
+static void fill(size_t n) {
+    gc = new gc_t();
+    list = new BasikList();
+    list->reserve(n);
+    for (size_t i = 0; i < n; i++) list->append(new basik_val{DataType::I64,new BasikI64(i)});
+}
+
+static void destroy(size_t n) {
+    for (size_t i = 0; i < n; i++) delete (*list)[i];
+    delete list;
+    delete gc;
+}
+
+int main(int argc, const char** argv) {
+
+    for (size_t n : micro_sizes) {
+        if (micro_selected(argc,argv,"list.slice"))
+            micro_run("list.slice",n,ops,fill,[](size_t n) {
+                for (size_t i = 0; i < ops; i++) {
+                    BasikList* s = new BasikList(list,1,n-1);
+                    micro_keep(s);
+                    delete s;
+                }
+            },destroy);
+        // What slicing used to cost, and what the first write to a slice still costs
+        if (micro_selected(argc,argv,"list.slice.write"))
+            micro_run("list.slice.write",n,ops,fill,[](size_t n) {
+                for (size_t i = 0; i < ops; i++) {
+                    BasikList* s = new BasikList(list,1,n-1);
+                    s->own(gc);
+                    micro_keep(s);
+                    delete s;
+                }
+            },destroy);
+    }
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "basik.h"
+
+#include <time.h>
+
+/**
+ * A tiny harness for the microbenchmarks of the VM internals
+ * Every benchmark is ran for a range of sizes and prints one line per size, so that
+ * the scaling curve of a structure can be compared before and after a change
+ */
+
+// The sizes every benchmark is ran with, unless it provides its own
+const size_t micro_sizes[] = { 16, 64, 256, 1024, 4096, 16384 };
+
+inline uint64_t micro_now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000llu + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Prevents the compiler from optimizing a value away
+ */
+template<typename T>
+inline void micro_keep(T const& v) {
+    asm volatile("" : : "r,m"(v) : "memory");
+}
+
+/**
+ * Runs a benchmark `reps` times and prints the best time per operation
+ * `setup(n)` prepares a run and is not timed, `fn(n)` is timed and performs `ops` operations,
+ * `teardown(n)` cleans up after a run and is not timed either
+ */
+template<typename S, typename F, typename T>
+void micro_run(const char* name, size_t n, size_t ops, S setup, F fn, T teardown, int reps = 5) {
+    uint64_t best = -1llu;
+    for (int r = 0; r < reps; r++) {
+        setup(n);
+        uint64_t t = micro_now();
+        fn(n);
+        t = micro_now()-t;
+        teardown(n);
+        if (t < best) best = t;
+    }
+    printf("%-24s n=%-8zu %12.2f ns/op\n",name,n,(double)best/(ops?ops:1));
+    fflush(stdout);
+}
+
+template<typename F>
+void micro_run(const char* name, size_t n, size_t ops, F fn, int reps = 5) {
+    micro_run(name,n,ops,[](size_t){},fn,[](size_t){},reps);
+}
+
+/**
+ * Whether a benchmark was selected on the command line (`./micro <name>...`), all of them are if none was
+ */
+inline bool micro_selected(int argc, const char** argv, const char* name) {
+    if (argc <= 1) return true;
+    for (int i = 1; i < argc; i++)
+        if (strstr(name,argv[i]) != nullptr) return true;
+    return false;
+}
@@ -0,0 +1,63 @@
+#include "micro.h"
+#include "native.h"
+
+static basik_val* args[2];
+
+// The VM calls builtins through a pointer, so both versions are called the same way
+static Result(* volatile manual)(Code*,size_t,basik_val**);
+static Result(* volatile bound)(Code*,size_t,basik_val**);
+
+static int64_t count(std::string_view s, int64_t c) {
+    int64_t n = 0;
+    for (char x : s) n += x == c;
+    return n;
+}
+
+/**
+ * The same function glued by hand, the way the builtins are written
+ */
+static Result count_manual(Code* code, size_t argc, basik_val** argv) {
+    if (argc != 2) return builtin_error(code,"Expected 2 arguments, got %zu",argc);
+    if (argv[0] == nullptr || argv[0]->type != DataType::String) return builtin_error(code,"Argument 1 should be a String, got `%s`",type_name(argv[0]));
+    int64_t c;
+    if (!int_value(argv[1],&c)) return builtin_error(code,"Argument 2 should be an integer, got `%s`",type_name(argv[1]));
+    BasikString* s = (BasikString*)argv[0]->data;
+    return Result{nullptr,val_i64(count(std::string_view((const char*)s->data,s->len-1),c))};
+}
+
+static void make_args(size_t n) {
+    args[0] = new basik_val{DataType::String,new BasikString(5,"abca")};
+    args[1] = val_i64('a');
+}
+
+static void free_args(size_t n) {
+    delete args[0];
+}
+
+int main(int argc, const char** argv) {
+
+    manual = count_manual;
+    bound = bind<count>;
+
+    // Checks the conversions once, the benchmarks only go through the successful path
+    make_args(0);
+    Result r = bound(nullptr,2,args);
+    if (r.except != nullptr || *((BasikI64*)r.value->data)->data != 2) {
+        fprintf(stderr,"bind<count> gave a wrong result\n");
+        return 1;
+    }
+    free_args(0);
+
+    for (size_t n : micro_sizes) {
+        if (micro_selected(argc,argv,"native.manual"))
+            micro_run("native.manual",n,n,make_args,[](size_t n) {
+                for (size_t i = 0; i < n; i++) micro_keep(manual(nullptr,2,args).value);
+            },free_args);
+        if (micro_selected(argc,argv,"native.bind"))
+            micro_run("native.bind",n,n,make_args,[](size_t n) {
+                for (size_t i = 0; i < n; i++) micro_keep(bound(nullptr,2,args).value);
+            },free_args);
+    }
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "micro.h"
+
+static basik_val* args[3];
+static Output* output = nullptr;
+static Code* code = nullptr;
+
+int main(int argc, const char** argv) {
+
+    FILE* null = fopen("/dev/null","w");
+    output = new Output(null,65536);
+    output->line_buffered = false;
+    // `print` writes to the output of the globals of its caller
+    gc_t* gc = new gc_t();
+    Globals* glob = new Globals(gc);
+    glob->output = output;
+    code = new Code(gc,glob,nullptr,0,nullptr);
+
+    const char* text = "of the output";
+    args[0] = new basik_val{DataType::String,new BasikString(strlen("line")+1,"line")};
+    args[1] = new basik_val{DataType::I64,new BasikI64(-1234567)};
+    args[2] = new basik_val{DataType::String,new BasikString(strlen(text)+1,text)};
+
+    for (size_t n : micro_sizes) {
+        // What `print` used to do: one printf per argument and separator
+        if (micro_selected(argc,argv,"print.stdio"))
+            micro_run("print.stdio",n,n,[null](size_t n) {
+                for (size_t i = 0; i < n; i++) {
+                    fprintf(null,"%s",((BasikString*)args[0]->data)->data);
+                    fprintf(null," ");
+                    fprintf(null,"%zi",*((BasikI64*)args[1]->data)->data);
+                    fprintf(null," ");
+                    fprintf(null,"%s",((BasikString*)args[2]->data)->data);
+                    fprintf(null,"\n");
+                }
+                fflush(null);
+            });
+        if (micro_selected(argc,argv,"print.buffered"))
+            micro_run("print.buffered",n,n,[](size_t n) {
+                for (size_t i = 0; i < n; i++) basik_std_print(code,3,args);
+                output->flush();
+            });
+        if (micro_selected(argc,argv,"print.line_buffered"))
+            micro_run("print.line_buffered",n,n,[](size_t n) {
+                output->line_buffered = true;
+                for (size_t i = 0; i < n; i++) basik_std_print(code,3,args);
+                output->line_buffered = false;
+            });
+    }
+
+    return 0;
+}
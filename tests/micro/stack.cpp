@@ -0,0 +1,52 @@
+#include "micro.h"
+
+int main(int argc, const char** argv) {
+
+    static Stack<size_t>* s = nullptr;
+
+    auto create = [](size_t n) {
+        s = new Stack<size_t>();
+    };
+    auto fill = [](size_t n) {
+        s = new Stack<size_t>();
+        for (size_t i = 0; i < n; i++) s->push(i+1);
+    };
+    auto fill_holes = [](size_t n) {
+        s = new Stack<size_t>();
+        for (size_t i = 0; i < n; i++) s->push(i%2 ? i : 0);
+    };
+    auto destroy = [](size_t n) {
+        delete s;
+        s = nullptr;
+    };
+
+    for (size_t n : micro_sizes) {
+        if (micro_selected(argc,argv,"stack.push"))
+            micro_run("stack.push",n,n,create,[](size_t n) {
+                for (size_t i = 0; i < n; i++) s->push(i);
+                micro_keep(s->data);
+            },destroy);
+        if (micro_selected(argc,argv,"stack.push.reserved"))
+            micro_run("stack.push.reserved",n,n,create,[](size_t n) {
+                s->reserve(n);
+                for (size_t i = 0; i < n; i++) s->push(i);
+                micro_keep(s->data);
+            },destroy);
+        if (micro_selected(argc,argv,"stack.reserve"))
+            micro_run("stack.reserve",n,n,fill,[](size_t n) {
+                s->reserve(s->cap+n);
+                micro_keep(s->data);
+            },destroy);
+        if (micro_selected(argc,argv,"stack.prune"))
+            micro_run("stack.prune",n,n,fill_holes,[](size_t n) {
+                s->prune();
+                micro_keep(s->data);
+            },destroy);
+        if (micro_selected(argc,argv,"stack.pop"))
+            micro_run("stack.pop",n,n,fill,[](size_t n) {
+                for (size_t i = 0; i < n; i++) micro_keep(s->pop());
+            },destroy);
+    }
+
+    return 0;
+}
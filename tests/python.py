@@ -8,6 +8,8 @@ tests: dict[str] = {}
 errs: set[str] = set()
 
 for fn in os.listdir('./tests/python'):
+    # The modules of a test are in a directory of the same name
+    if os.path.isdir(os.path.join('./tests/python',fn)): continue
     idx, f = fn.split('-')
     f, kind = f.split('.')
     if kind == 'out':
@@ -16,7 +18,10 @@ for fn in os.listdir('./tests/python'):
     
 for test, out in tests.items():
     print('[COMPILE] %s'%(test),end='')
-    p = subprocess.Popen('python3 compiler.py %s %s'%(shlex.quote(os.path.join('./tests/python/',test+'.py')),shlex.quote(os.path.join('./tests/tmp/','python-'+test+'.bsk'))),shell=True,universal_newlines=True,stdout=subprocess.PIPE,stderr=subprocess.PIPE)
+    # They are linked along with it
+    mod_dir = os.path.join('./tests/python/',test)
+    modules = [os.path.join(mod_dir,m) for m in sorted(os.listdir(mod_dir)) if m.endswith('.py')] if os.path.isdir(mod_dir) else []
+    p = subprocess.Popen('python3 compiler.py %s %s'%(' '.join(shlex.quote(f) for f in [os.path.join('./tests/python/',test+'.py')]+modules),shlex.quote(os.path.join('./tests/tmp/','python-'+test+'.bsk'))),shell=True,universal_newlines=True,stdout=subprocess.PIPE,stderr=subprocess.PIPE)
     stdout, stderr = p.communicate()
     if p.returncode != 0:
         errs.add('cmp:'+test)
@@ -33,8 +38,12 @@ for test, out in tests.items():
     bsk_file = os.path.join('./tests/tmp/','python-'+test+'.bsk')
     if 'cmp:'+test not in errs:
         print('[RUN] %s'%(test,),end='')
-        p = subprocess.Popen('./out/basik %s'%(shlex.quote(bsk_file),),shell=True,universal_newlines=True,stdout=subprocess.PIPE,stderr=subprocess.PIPE,errors='ignore')
+        # The program gets `<test>.in` as its input if there is one
+        in_file = os.path.join('./tests/python/',test+'.in')
+        stdin = open(in_file,'r') if os.path.exists(in_file) else subprocess.DEVNULL
+        p = subprocess.Popen('./out/basik %s'%(shlex.quote(bsk_file),),shell=True,universal_newlines=True,stdin=stdin,stdout=subprocess.PIPE,stderr=subprocess.PIPE,errors='ignore')
         stdout, stderr = p.communicate()
+        if stdin != subprocess.DEVNULL: stdin.close()
         if p.returncode != 0:
             errs.add('run:'+test)
             errs.add('err:'+test)
@@ -53,6 +62,58 @@ for test, out in tests.items():
     
 print()
 
+print('----- Compilation cache tests -----')
+
+def compile_bytes(files:list[str], *flags:str) -> bytes:
+    out = os.path.join('./tests/tmp/','cache.bsk')
+    subprocess.run(['python3','compiler.py',*flags,*files,out],check=True,stdout=subprocess.DEVNULL)
+    with open(out,'rb') as f:
+        return f.read()
+
+def write_program(lines_above:int, scale:bool=False) -> str:
+    # A function that fails on a known line, after a variable amount of lines
+    # `scale` is a global only when it is defined before `f`, which changes how `f` is compiled
+    src = os.path.join('./tests/tmp/','cache-program.py')
+    with open(src,'w') as f:
+        f.write('x = 1\n'*lines_above)
+        f.write('def scale():\n    return 2\n\n' if scale else '')
+        f.write('def f(n):\n    return len(n) * scale()\n\nf(5)\n')
+    return src
+
+cache_dir = os.path.join('./tests/tmp/','cache')
+cache_checks = []
+try:
+    # Every compilation that goes through the cache has to give what compiling without it does,
+    # whether it missed, hit, or hit a body that moved in the file
+    src = write_program(0)
+    plain = compile_bytes([src])
+    cache_checks.append(('miss',compile_bytes([src],'--cache',cache_dir) == plain))
+    cache_checks.append(('hit',compile_bytes([src],'--cache',cache_dir) == plain))
+    src = write_program(3)
+    cached = compile_bytes([src],'--cache',cache_dir)
+    # The line of the function in the trace follows the lines inserted above it
+    p = subprocess.run(['./out/basik',os.path.join('./tests/tmp/','cache.bsk')],capture_output=True,text=True,errors='ignore')
+    cache_checks.append(('lines','cache-program.py:5,' in p.stderr))
+    cache_checks.append(('moved',cached == compile_bytes([src])))
+    # Nothing in the body of the function changed, but one of the names it uses became a global
+    src = write_program(3,True)
+    cache_checks.append(('global',compile_bytes([src],'--cache',cache_dir) == compile_bytes([src])))
+    # Modules are compiled by a pool of processes that share the cache
+    files = ['./tests/python/16-modules.py','./tests/python/16-modules/shapes.py']
+    plain = compile_bytes(files)
+    cache_checks.append(('jobs',compile_bytes(files,'--jobs','2','--cache',cache_dir) == plain and compile_bytes(files,'--jobs','2','--cache',cache_dir) == plain))
+except subprocess.CalledProcessError:
+    cache_checks.append(('compile',False))
+
+tests['cache'] = None
+for name, ok in cache_checks:
+    print('[CACHE] %s'%(name,)+' '*(10-len(name))+(' \x1b[32m[SUCCESS]\x1b[39m' if ok else ' \x1b[31m[FAILED]\x1b[39m'))
+    if not ok:
+        errs.add('out:cache')
+        errs.add('err:cache')
+
+print()
+
 ec = sum(e.startswith('err:') for e in errs) # Error count
 sc = len(tests)-ec                           # Success count
 ec_cmp = sum(e.startswith('cmp:') for e in errs) # Compilation errors count
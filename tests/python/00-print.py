@@ -2,4 +2,8 @@ print("Hello, world !")
 print("Hello,","world !")
 print("Hello,","world","!")
 print(10)
-print(284525)
\ No newline at end of file
+print(284525)
+print(0, -7, 9223372036854775807)
+print()
+flush()
+print(None, 1 == 1)
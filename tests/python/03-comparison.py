@@ -20,4 +20,13 @@ if print() == 1:
     print('G')
     
 if print == print:
-    print('H')
\ No newline at end of file
+    print('H')
+if 'abc' == 'abc':
+    print('I')
+
+if 'abc' == 'abd':
+    print('J')
+
+s = 'abc'
+if s == 'abc':
+    print('K')
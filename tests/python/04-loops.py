@@ -0,0 +1,24 @@
+n = 3
+while n:
+    print(n)
+    n = n - 1
+else:
+    print('done')
+
+n = 5
+while 1:
+    n = n - 1
+    if n == 3:
+        continue
+    if n == 1:
+        break
+    print(n)
+
+def add(a, b):
+    return a + b
+
+def nothing():
+    return
+
+print(add(1, 2), add(3, 4))
+print(nothing())
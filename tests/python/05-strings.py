@@ -0,0 +1,16 @@
+s = 'Hello'
+s = s + ', ' + 'World'
+print(s)
+
+line = ''
+n = 20
+while n:
+    line = line + 'abcd'
+    n = n - 1
+print(line)
+print(line == 'abcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcd')
+
+print(join(['a','b','c']))
+print(join(['a','b','c'],', '))
+print(join([line,s],'|'))
+print(join([]) == '')
@@ -0,0 +1,12 @@
+name = input()
+print('Hello,', name)
+books = {'Alice in wonderland': 1865}
+print(books[name])
+
+line = readline()
+while line:
+    print(join(['[', line, ']']))
+    line = readline()
+
+print(input() == None)
+print(join(lines('tests/python/06-input.in')))
@@ -0,0 +1,15 @@
+data = read('tests/python/07-files.data')
+mapped = mmap_file('tests/python/07-files.data')
+print(data == mapped)
+
+rows = split(mapped, '\n')
+print(join(rows, ' | '))
+print(join(split('  a b\tc\n  d  '), ','))
+print(join(split('a,,b,', ','), ';'))
+
+print(find(mapped, 'pear'), find(mapped, 'kiwi'), find(mapped, 'p', 20))
+
+f = open('tests/python/07-files.data')
+print(join([readline(f), readline(f)]))
+print(join(lines(f), '/'))
+print(read(f) == '')
@@ -0,0 +1,29 @@
+prices = {'apple': 3, 'pear': 12}
+print(prices['apple'], prices['pear'])
+
+prices['plum'] = 7
+prices['apple'] = prices['apple'] + 1
+print(prices['apple'], prices['plum'])
+
+key = join(['pe', 'ar'])
+print(prices[key])
+
+parts = split('apple,pear', ',')
+print(prices[parts[0]], prices[parts[1]])
+
+squares = {}
+n = 100
+while n:
+    squares[n] = n * n
+    n = n - 1
+print(squares[12], squares[100])
+
+l = [1, 2, 3]
+l[0] = 10
+l[-1] = l[1] + 1
+print(l[0], l[1], l[2])
+
+if {}:
+    print('not empty')
+if squares:
+    print('squares')
@@ -0,0 +1,46 @@
+a = array([3, -1, 4, 1, -5, 9, 2, 6])
+print(len(a), sum(a), min(a), max(a))
+print(a[0], a[-1])
+
+b = a * 2 + 1
+print(b[0], b[4], sum(b))
+c = 10 - a
+print(c[0], c[5])
+d = a + b
+print(d[1], d[7])
+
+a[1] = 100
+print(a[1], max(a))
+
+big = filter(a, '>', 2)
+print(len(big), sum(big))
+mask = compare(a, '<=', 1)
+print(sum(mask), mask[3], mask[0])
+gt = a > 2
+print(sum(gt), sum(2 < a), sum(a == 100), sum(-5 >= a), len(b <= 3))
+
+n = 1000
+z = array(n, 'i16')
+z = z + 7
+print(len(z), sum(z), z[999])
+
+w = array([1, 2, 3], 'i32') * array([4, 5, 6], 'i32')
+print(sum(w))
+
+small = array([1, 2, 3], 'i16')
+print(len(filter(small, '<', 40000)), len(filter(small, '>', 65537)), sum(compare(small, '==', 65537)), sum(compare(small, '!=', -70000)))
+
+h = array([70000, -32768, 32767])
+t = array(h, 'i32')
+hs = array([32767, -32768], 'i16')
+hs[0] = -32768
+print(sum(t), hs[0], hs[1])
+
+x = 40
+l = array([x, x + 1, 3])
+print(sum(l), len([1, 2]), len('abc'), len({'k': 1}))
+
+if array(0):
+    print('not empty')
+if a:
+    print('a')
@@ -0,0 +1,50 @@
+def square(x):
+    return x * x
+
+def odd(x):
+    return x - x / 2 * 2
+
+def add(a, b):
+    return a + b
+
+def sub(a, b):
+    return a - b
+
+def box(x):
+    return {'v': x}
+
+def remember(x):
+    global seen
+    seen = x
+    return x
+
+s = ''
+n = 100
+while n:
+    s = s + 'a bb ccc dddd eeeee '
+    n = n - 1
+
+nums = map(len, split(s))
+print(len(nums), sum(nums))
+
+squares = map(square, nums)
+print(len(squares), sum(squares), squares[3])
+
+odds = filter(odd, nums)
+print(len(odds), sum(odds))
+
+print(reduce(add, nums), reduce(add, nums, 10), reduce(add, [7]))
+
+ordered = sort(nums)
+print(ordered[0], ordered[99], ordered[100], ordered[-1])
+
+fruits = sort(split('pear apple fig applesauce'))
+print(fruits[0], fruits[1], fruits[2], fruits[3])
+
+# Callbacks that need more than isolates have run on the calling thread, whatever the amount of threads
+boxes = map(box, nums)
+print(len(boxes), boxes[0]['v'], boxes[499]['v'])
+seen = 0
+map(remember, nums)
+print(seen)
+print(reduce(sub, nums), reduce(add, nums, 0, True), reduce(add, nums, None, True))
@@ -0,0 +1,31 @@
+l = ['a', 'b', 'c', 'd', 'e']
+print(len(l[1:3]), l[1:3][0], l[1:3][1])
+print(len(l[:2]), len(l[3:]))
+print(len(l[:]), len(l[-2:]))
+print(len(l[4:1]), len(l[-100:100]))
+print(l[-2:][0], l[:-1][3])
+
+t = l[1:4]
+t[0] = 'x'
+print(l[1], t[0], t[1])
+l[2] = 'y'
+print(l[2], t[1])
+
+u = t[1:]
+print(len(u), u[0], u[1])
+
+s = 'hello world'
+print(s[6:], s[:5])
+print(s[-3:], len(s[2:2]))
+
+words = split('a b c d e f g h')
+tail = words[2:]
+print(len(tail), tail[0], join(tail[:3]))
+
+# The first write to a slice that outlived its list gives the storage of the list back
+for i in range(16000):
+    x = split('a b c d')
+    y = x[1:]
+    x = 0
+    y[0] = 'z'
+print(len(y), y[0], y[2])
@@ -0,0 +1,20 @@
+print(True, False)
+print(1 == 1, 1 == 2)
+if True:
+    print('true')
+if False:
+    print('false')
+
+print(1023 + 1, 1024 - 1)
+print(-128 - 1, -129 + 1)
+
+a = array([1000, 70000], 'i32')
+print(a[0] + a[0], a[1] * a[0])
+
+b = array([-5, 30000], 'i16')
+print(b[0] * b[0], b[1] - b[0])
+
+n = 2000
+while n:
+    n = n - 1
+print(n)
@@ -0,0 +1,52 @@
+for i in range(3):
+    print(i)
+
+for i in range(5, 0, -2):
+    print(i)
+
+for i in range(2, 2):
+    print('never')
+else:
+    print('empty')
+
+total = 0
+for i in range(100):
+    if i == 10:
+        continue
+    if i >= 20:
+        break
+    total = total + i
+print(total)
+
+for i in range(3):
+    for j in range(i, 3):
+        if j != i:
+            print(i, j)
+
+for i in range(3):
+    i = 10
+print(i)
+
+n = 0
+while n < 4:
+    n = n + 1
+print(n)
+
+print(1 < 2, 2 <= 2, 3 > 4)
+print(3 >= 4, 1 != 2, 'a' < 'b')
+print('ab' < 'a', 'ab' > 'a')
+print(1 != None, None != None)
+
+def fact(n):
+    if n <= 1:
+        return 1
+    return n * fact(n - 1)
+
+def count(a, b):
+    c = 0
+    for k in range(a, b):
+        c = c + 1
+    return c
+
+print(fact(10))
+print(count(3, 10), count(10, 3))
@@ -0,0 +1,13 @@
+print(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12)
+print([[1, [2, [3, [4, [5, 'a']]]]]][0][1][1][1][1][1])
+
+def sum6(a, b, c, d, e, f):
+    return a + (b + (c + (d + (e + f))))
+
+def depth(n, a, b, c):
+    if n == 0:
+        return a * b * c
+    return depth(n - 1, a, b, c) + sum6(n, n, n, n, n, n)
+
+print(sum6(1, 2, 3, 4, 5, 6), depth(50, 2, 3, 4))
+print(sum6(1, 2, 3, 4, 5, 6) - sum6(6, 5, 4, 3, 2, 1), 'end', 1 + (2 + (3 + (4 + (5 + (6 + (7 + (8 + 9))))))))
@@ -0,0 +1,26 @@
+def one(x):
+    return 1
+
+def two(x):
+    return 2
+
+def call():
+    return one(0)
+
+print(call())
+one = two
+print(call())
+
+fs = [one, two, print, len, two]
+for i in range(5):
+    f = fs[i]
+    print(i, f('ab'))
+
+def show(x):
+    global counter
+    counter = counter + x
+    return counter
+
+counter = 0
+for i in range(4):
+    print(show(i), counter)
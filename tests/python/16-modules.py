@@ -0,0 +1,12 @@
+from shapes import area
+print(area(3, 4))
+
+def measure(w, h):
+    import shapes
+    global perimeter
+    return perimeter(w, h)
+
+print(measure(2, 5), measure(1, 1))
+
+import shapes
+print(area(6, 7))
@@ -0,0 +1,7 @@
+print('loading shapes')
+
+def area(w, h):
+    return w * h
+
+def perimeter(w, h):
+    return 2 * (w + h)